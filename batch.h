@@ -0,0 +1,423 @@
+/*
+ *
+ * This file contains the BatchRunner class that plays many games at once, one
+ * per worker thread, and hands back their results as they finish
+ *
+ * --- Code Summary ---
+ * Games are submitted as a config file & seed, as a ScenarioGenerator & seed
+ * (the config is generated in memory by the worker that plays the game) or as
+ * a GameState (e.g. a fork of a mid-game state), and are played headless until
+ * they end. Every
+ * game is played entirely on one worker thread: the robot queues, board size,
+ * action log & random number generator are all kept per thread, so the games
+ * on different workers never share anything.
+ *
+ * Games in a batch vary wildly in length, so they are not split up front.
+ * Every worker has its own queue of games: submitted games are dealt out to
+ * the queues in turn, every worker plays the games of its own queue in the
+ * order they were submitted, and a worker whose queue is empty steals the
+ * most recently submitted game of another worker's queue. Workers only sleep
+ * when no queue holds a game, so the workers stay busy until the batch is
+ * almost done.
+ *
+ * Results are collected with nextResult() in the order the games finish.
+ *
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "deque.h"
+#include "generator.h"
+#include "interface.h"
+
+using namespace std;
+
+/// @brief The outcome of one game of a batch
+struct BatchResult
+{
+    /// @brief the number returned by BatchRunner::submit() for the game
+    int id = 0;
+
+    /// @brief false if the game could not be started, in which case error describes why
+    bool isValid = true;
+    string error;
+
+    /// @brief turn the game ended on
+    int turn = 0;
+
+    /// @brief robots alive at the end of the game
+    int aliveCount = 0;
+
+    /// @brief name of the last robot standing, empty if the turn limit was reached with several robots alive
+    string winner;
+
+    /// @brief kills & evolutions during the game
+    long long killCount = 0;
+    long long evolveCount = 0;
+
+    /// @brief time taken to set up the game and to play it
+    chrono::nanoseconds setupTime = chrono::nanoseconds::zero();
+    chrono::nanoseconds playTime = chrono::nanoseconds::zero();
+};
+
+class BatchRunner
+{
+private:
+    /// @brief A game waiting to be played
+    struct BatchGame
+    {
+        int id = 0;
+
+        /// @brief the game is started from state if isFromState, from the config generated by
+        /// generator if isGenerated, otherwise from configFilename. The last two are seeded with seed
+        bool isFromState = false;
+        bool isGenerated = false;
+        string configFilename;
+        ScenarioGenerator generator;
+        unsigned int seed = 0;
+        GameState state;
+    };
+
+    /// @brief A worker thread and its queue of games
+    struct Worker
+    {
+        mutex queueMutex;
+        Deque<BatchGame> games;
+        thread workerThread;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+
+    /// @brief guards everything below
+    mutex stateMutex;
+
+    /// @brief signalled when a game is submitted or the runner stops
+    condition_variable gameSubmitted;
+
+    /// @brief signalled when a game finishes
+    condition_variable gameFinished;
+
+    /// @brief games in the workers' queues that no worker has taken yet
+    int queuedCount = 0;
+
+    /// @brief games whose results have not been collected yet
+    int uncollectedCount = 0;
+
+    /// @brief results of finished games that have not been collected yet, in the order they finished
+    Deque<BatchResult> results;
+
+    bool isStopping = false;
+
+    int nextId = 0;
+
+    /// @brief worker the next submitted game is dealt to
+    int nextWorker = 0;
+
+    int enqueue(BatchGame game);
+    bool takeGame(int workerIndex, BatchGame &game);
+    void runWorker(int workerIndex);
+    static BatchResult play(BatchGame &game);
+
+public:
+    /// @param threadCount number of worker threads, 0 for one per core
+    BatchRunner(int threadCount = 0);
+
+    /// @brief Stops the workers once they have finished the games they are playing.
+    /// Games that have not been started yet are never played
+    ~BatchRunner();
+
+    BatchRunner(const BatchRunner &) = delete;
+    BatchRunner &operator=(const BatchRunner &) = delete;
+
+    /// @brief Submits a game started from a config file
+    /// @param configFilename config file, binary scenario or checkpoint to start the game from
+    /// @param seed seed of the game's random number generator
+    /// @return number identifying the game in its BatchResult
+    int submit(const string &configFilename, unsigned int seed);
+
+    /// @brief Submits a game started from a generated config, without writing it to a file
+    /// @param generator parameters of the config, generated by the worker playing the game
+    /// @param seed seed of the game's random number generator
+    /// @return number identifying the game in its BatchResult
+    int submit(const ScenarioGenerator &generator, unsigned int seed);
+
+    /// @brief Submits a game started from a game state
+    /// @param state state to start the game from, e.g. from GameState::fork()
+    /// @return number identifying the game in its BatchResult
+    int submit(GameState state);
+
+    /// @brief Waits for the next game to finish
+    /// @param result the result of the game
+    /// @return false if every submitted game's result has already been collected
+    bool nextResult(BatchResult &result);
+
+    int getThreadCount() const;
+};
+
+inline BatchRunner::BatchRunner(int threadCount)
+{
+    if (threadCount <= 0)
+    {
+        threadCount = max((int)thread::hardware_concurrency(), 1);
+    }
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers.push_back(make_unique<Worker>());
+    }
+
+    // the workers are only started once every queue exists, since they steal from each other
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers[i]->workerThread = thread(&BatchRunner::runWorker, this, i);
+    }
+}
+
+inline BatchRunner::~BatchRunner()
+{
+    {
+        lock_guard<mutex> lock(stateMutex);
+        isStopping = true;
+    }
+
+    gameSubmitted.notify_all();
+
+    for (unique_ptr<Worker> &worker : workers)
+    {
+        worker->workerThread.join();
+    }
+}
+
+inline int BatchRunner::submit(const string &configFilename, unsigned int seed)
+{
+    BatchGame game;
+    game.configFilename = configFilename;
+    game.seed = seed;
+
+    return enqueue(move(game));
+}
+
+inline int BatchRunner::submit(const ScenarioGenerator &generator, unsigned int seed)
+{
+    BatchGame game;
+    game.isGenerated = true;
+    game.generator = generator;
+    game.seed = seed;
+
+    return enqueue(move(game));
+}
+
+inline int BatchRunner::submit(GameState state)
+{
+    BatchGame game;
+    game.isFromState = true;
+    game.state = move(state);
+
+    return enqueue(move(game));
+}
+
+/// @brief Deals a game out to the next worker's queue
+inline int BatchRunner::enqueue(BatchGame game)
+{
+    int workerIndex;
+    {
+        lock_guard<mutex> lock(stateMutex);
+
+        game.id = nextId++;
+        workerIndex = nextWorker;
+        nextWorker = (nextWorker + 1) % workers.size();
+        uncollectedCount++;
+    }
+
+    int id = game.id;
+    {
+        lock_guard<mutex> lock(workers[workerIndex]->queueMutex);
+        workers[workerIndex]->games.push_back(move(game));
+    }
+
+    // the count only goes up once the game is in a queue, so a worker woken up by it finds a game unless another worker took it first
+    {
+        lock_guard<mutex> lock(stateMutex);
+        queuedCount++;
+    }
+
+    gameSubmitted.notify_one();
+
+    return id;
+}
+
+/// @brief Takes the oldest game of a worker's own queue, or else steals the newest
+/// game of another worker's queue
+/// @return false if every queue was empty
+inline bool BatchRunner::takeGame(int workerIndex, BatchGame &game)
+{
+    bool isTaken = false;
+
+    for (int i = 0; i < (int)workers.size() && !isTaken; i++)
+    {
+        Worker &victim = *workers[(workerIndex + i) % workers.size()];
+        lock_guard<mutex> lock(victim.queueMutex);
+
+        if (!victim.games.is_empty())
+        {
+            game = i == 0 ? victim.games.pop_front() : victim.games.pop_back();
+            isTaken = true;
+        }
+    }
+
+    if (isTaken)
+    {
+        lock_guard<mutex> lock(stateMutex);
+        queuedCount--;
+    }
+
+    return isTaken;
+}
+
+inline void BatchRunner::runWorker(int workerIndex)
+{
+    BatchGame game;
+
+    while (true)
+    {
+        if (!takeGame(workerIndex, game))
+        {
+            unique_lock<mutex> lock(stateMutex);
+            gameSubmitted.wait(lock, [this] { return isStopping || queuedCount > 0; });
+
+            if (isStopping)
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        BatchResult result = play(game);
+        bool isStopped;
+
+        {
+            lock_guard<mutex> lock(stateMutex);
+            results.push_back(move(result));
+            isStopped = isStopping;
+        }
+
+        gameFinished.notify_all();
+
+        if (isStopped)
+        {
+            return;
+        }
+    }
+}
+
+/// @brief Plays a game headless on the calling thread until it ends
+inline BatchResult BatchRunner::play(BatchGame &game)
+{
+    BatchResult result;
+    result.id = game.id;
+
+    long long killsBefore = Robot::killCount;
+    long long evolutionsBefore = Robot::evolveCount;
+
+    try
+    {
+        auto setupStart = chrono::steady_clock::now();
+
+        if (!game.isFromState)
+        {
+            RNG::seed(game.seed);
+        }
+
+        // the generated config only has to outlive the game's construction
+        string configText = game.isGenerated ? game.generator.generate() : string();
+
+        Game batchGame = game.isFromState   ? Game(game.state, true)
+                         : game.isGenerated ? Game(InMemoryConfig{configText}, true)
+                                            : Game(game.configFilename, true);
+
+        auto playStart = chrono::steady_clock::now();
+        result.setupTime = playStart - setupStart;
+
+        while (batchGame.isValidState())
+        {
+            batchGame.nextTurn();
+        }
+
+        result.playTime = chrono::steady_clock::now() - playStart;
+
+        result.turn = batchGame.getTurn();
+        result.aliveCount = Robot::robotDeque.size();
+
+        if (Robot::robotDeque.size() == 1)
+        {
+            result.winner = Robot::robotDeque.front()->getName();
+        }
+    }
+    catch (MappedFile::OpeningError)
+    {
+        result.isValid = false;
+        result.error = "Error opening config file " + game.configFilename;
+    }
+    catch (const ConfigParser::ConfigError &error)
+    {
+        result.isValid = false;
+        result.error = (game.isGenerated ? string("generated config") : game.configFilename) + ":" + to_string(error.line) + ":" + to_string(error.column) + ": " + error.message;
+    }
+    catch (Scenario::InvalidScenario)
+    {
+        result.isValid = false;
+        result.error = "The binary scenario file is invalid";
+    }
+    catch (GameState::InvalidCheckpoint)
+    {
+        result.isValid = false;
+        result.error = "The checkpoint file is invalid";
+    }
+    catch (ScenarioGenerator::InvalidParameters)
+    {
+        result.isValid = false;
+        result.error = "The generator parameters cannot produce a valid config";
+    }
+
+    result.killCount = Robot::killCount - killsBefore;
+    result.evolveCount = Robot::evolveCount - evolutionsBefore;
+
+    // the game's state is no longer needed, and a forked state can be large
+    game.state = GameState();
+
+    return result;
+}
+
+inline bool BatchRunner::nextResult(BatchResult &result)
+{
+    unique_lock<mutex> lock(stateMutex);
+
+    if (uncollectedCount == 0)
+    {
+        return false;
+    }
+
+    gameFinished.wait(lock, [this] { return !results.is_empty(); });
+
+    result = results.pop_front();
+    uncollectedCount--;
+
+    return true;
+}
+
+inline int BatchRunner::getThreadCount() const
+{
+    return workers.size();
+}
+
+#endif
@@ -0,0 +1,1277 @@
+/*
+ *
+ * This file contains the benchmark suite that measures the performance of the
+ * game engine
+ *
+ * --- Summary of code ---
+ * Every benchmark repeatedly runs one operation of the engine (a Deque
+ * operation, passing an element between threads through a queue, a Board refresh or board view, a terminal redraw, a Log message,
+ * a robot query, a bitboard query, a neighbourhood lookup, loading a config, a whole game turn, a simultaneous turn,
+ * branching a game or a batch of games) and reports the average time taken (ns/op) and the
+ * average number of heap allocations (allocs/op) per operation.
+ *
+ * All scenarios are generated from fixed seeds and the RNG is reseeded before
+ * every benchmark, so two runs of this program measure exactly the same work
+ * and can be compared to catch performance regressions.
+ *
+ * The full game benchmarks still write every frame to game.log, so this program
+ * should be run from the project folder (next to interface.template).
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "concurrentqueue.h"
+#include "generator.h"
+#include "interface.h"
+
+using namespace std;
+
+/*---------------------------------------------*/
+/*             Allocation Counting             */
+/*---------------------------------------------*/
+
+/// @brief Number of heap allocations made since the program started
+static atomic<long long> allocationCount(0);
+
+// The replacements are kept out of line: inlined into code that frees what it allocated,
+// GCC would pair the free() below with the new expression and warn that they mismatch
+
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    // counted atomically, since the simultaneous turn & batch benchmarks allocate on several threads
+    allocationCount.fetch_add(1, memory_order_relaxed);
+
+    void *memory = malloc(size == 0 ? 1 : size);
+
+    if (memory == nullptr)
+    {
+        throw bad_alloc();
+    }
+
+    return memory;
+}
+
+__attribute__((noinline)) void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+/*---------------------------------------------*/
+/*              Benchmark Harness              */
+/*---------------------------------------------*/
+
+/// @brief Minimum amount of time a benchmark is run for before its result is reported
+const chrono::nanoseconds MIN_BENCHMARK_TIME = chrono::milliseconds(200);
+
+/// @brief Runs a benchmark and prints its result
+/// @details body(n) must perform the measured operation n times. The number of
+///          operations is doubled until the benchmark has run for at least
+///          MIN_BENCHMARK_TIME. teardown() is called after every batch, outside
+///          of the measured time, to reset any state the batch left behind.
+/// @param name name of the benchmark
+/// @param body function that performs the operation a given number of times
+/// @param teardown function that resets the state after every batch
+void measure(const string &name, const function<void(long long)> &body, const function<void()> &teardown = nullptr)
+{
+    long long operations = 1;
+
+    while (true)
+    {
+        long long allocationsBefore = allocationCount;
+        auto start = chrono::steady_clock::now();
+
+        body(operations);
+
+        auto elapsed = chrono::steady_clock::now() - start;
+        long long allocations = allocationCount - allocationsBefore;
+
+        if (teardown)
+        {
+            teardown();
+        }
+
+        if (elapsed >= MIN_BENCHMARK_TIME || operations >= (1LL << 40))
+        {
+            double nsPerOp = (double)chrono::duration_cast<chrono::nanoseconds>(elapsed).count() / operations;
+
+            cout << left << setw(48) << name
+                 << right << setw(14) << fixed << setprecision(1) << nsPerOp << " ns/op"
+                 << setw(12) << setprecision(2) << (double)allocations / operations << " allocs/op"
+                 << setw(14) << operations << " ops\n";
+            return;
+        }
+
+        operations *= 2;
+    }
+}
+
+/// @brief Results that are written here cannot be optimized away by the compiler
+volatile long long benchmarkSink = 0;
+
+/// @brief Prints the header of a group of benchmarks
+/// @param title name of the benchmark group
+void printGroup(const string &title)
+{
+    cout << "\n[" << title << "]\n";
+}
+
+/*---------------------------------------------*/
+/*                 Board Setup                 */
+/*---------------------------------------------*/
+
+/// @brief Fills Robot::robotDeque with RoboCops placed on unique random positions,
+/// leaving the 5x5 area around the center of the board empty
+/// @param width board width
+/// @param height board height
+/// @param robotCount number of robots to place
+/// @param seed seed used to place the robots
+void populateBoard(int width, int height, int robotCount, unsigned int seed)
+{
+    Board board;
+    board.setWidth(width);
+    board.setHeight(height);
+    RNG::init(width, height);
+
+    mt19937 generator(seed);
+    uniform_int_distribution<int> randomX(0, width - 1);
+    uniform_int_distribution<int> randomY(0, height - 1);
+    set<pair<int, int>> usedPositions;
+
+    for (int i = 0; i < robotCount; i++)
+    {
+        pair<int, int> position;
+
+        do
+        {
+            position = {randomX(generator), randomY(generator)};
+        } while ((abs(position.first - width / 2) <= 2 && abs(position.second - height / 2) <= 2) || !usedPositions.insert(position).second);
+
+        Robot::robotDeque.push_back(new RoboCop("R" + to_string(i), position.first, position.second));
+    }
+}
+
+/// @brief Deletes every robot in the robot queues
+void clearBoard()
+{
+    while (!Robot::robotDeque.is_empty())
+    {
+        delete Robot::robotDeque.pop_back();
+    }
+
+    while (!Robot::reviveDeque.is_empty())
+    {
+        delete Robot::reviveDeque.pop_back();
+    }
+}
+
+/// @brief Discards everything written to stdout (the game writes its frames
+/// straight to the file descriptor) until restoreStdout() is called
+/// @return a copy of the original stdout, to be passed to restoreStdout()
+int discardStdout()
+{
+    cout.flush();
+
+    int originalStdout = dup(STDOUT_FILENO);
+    int nullFile = open("/dev/null", O_WRONLY);
+    dup2(nullFile, STDOUT_FILENO);
+    close(nullFile);
+
+    return originalStdout;
+}
+
+/// @brief Writes to stdout again after discardStdout()
+/// @param originalStdout the value returned by discardStdout()
+void restoreStdout(int originalStdout)
+{
+    cout.flush();
+
+    dup2(originalStdout, STDOUT_FILENO);
+    close(originalStdout);
+}
+
+/*---------------------------------------------*/
+/*                 Benchmarks                  */
+/*---------------------------------------------*/
+
+void benchmarkDeque()
+{
+    printGroup("Deque");
+
+    Deque<int> deque;
+
+    measure("push_back", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+            deque.push_back(i);
+    }, [&]() { deque.clear(); });
+
+    measure("push_front", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+            deque.push_front(i);
+    }, [&]() { deque.clear(); });
+
+    measure("push_back + pop_front", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            deque.push_back(i);
+            deque.pop_front();
+        }
+    });
+
+    measure("push_front + pop_back", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            deque.push_front(i);
+            deque.pop_back();
+        }
+    });
+
+    for (int size : {10, 100, 1000})
+    {
+        for (int i = 0; i < size; i++)
+        {
+            deque.push_back(i);
+        }
+
+        mt19937 generator(size);
+        uniform_int_distribution<int> randomIndex(0, size - 1);
+        vector<int> indexes(1024);
+        for (int &index : indexes)
+        {
+            index = randomIndex(generator);
+        }
+
+        long long sum = 0;
+        measure("operator[] random index, size " + to_string(size), [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                sum += deque[indexes[i & 1023]];
+        });
+
+        measure("size(), size " + to_string(size), [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                sum += deque.size();
+        });
+
+        measure("erase middle + push_back, size " + to_string(size), [&](long long n) {
+            for (long long i = 0; i < n; i++)
+            {
+                deque.erase(size / 2);
+                deque.push_back(i);
+            }
+        });
+
+        deque.clear();
+        benchmarkSink = sum;
+    }
+}
+
+/// @brief A Deque guarded by a mutex, the queue ConcurrentQueue is measured against
+/// @details Bounded like ConcurrentQueue, so both are measured doing the same work
+template <typename T>
+class LockedQueue
+{
+private:
+    mutex queueMutex;
+    Deque<T> deque;
+    int capacity;
+
+public:
+    LockedQueue(int capacity) : capacity(capacity)
+    {
+        deque.reserve(capacity);
+    }
+
+    bool push_back(T data)
+    {
+        lock_guard<mutex> lock(queueMutex);
+
+        if (deque.size() >= capacity)
+        {
+            return false;
+        }
+
+        deque.push_back(move(data));
+        return true;
+    }
+
+    bool pop_front(T &data)
+    {
+        lock_guard<mutex> lock(queueMutex);
+
+        if (deque.is_empty())
+        {
+            return false;
+        }
+
+        data = deque.pop_front();
+        return true;
+    }
+};
+
+/// @brief Passes itemCount items from producerCount threads to consumerCount threads through a queue
+/// @param queue queue with push_back & pop_front that fail when the queue is full or empty
+/// @param received called on the consumer thread with the consumer's number & every item it pops
+template <typename Queue, typename Received>
+void passItems(Queue &queue, int producerCount, int consumerCount, long long itemCount, Received received)
+{
+    atomic<int> activeProducers(producerCount);
+    vector<thread> threads;
+
+    for (int producer = 0; producer < producerCount; producer++)
+    {
+        threads.emplace_back([&, producer] {
+            // every item holds its producer in the low byte and its number in the rest
+            long long first = itemCount * producer / producerCount;
+            long long last = itemCount * (producer + 1) / producerCount;
+
+            for (long long i = first; i < last; i++)
+            {
+                while (!queue.push_back((i << 8) | producer))
+                {
+                    this_thread::yield();
+                }
+            }
+
+            activeProducers.fetch_sub(1, memory_order_release);
+        });
+    }
+
+    for (int consumer = 0; consumer < consumerCount; consumer++)
+    {
+        threads.emplace_back([&, consumer] {
+            long long item;
+
+            while (true)
+            {
+                // read before popping: once every producer has finished, a failed pop means every item has been popped
+                bool isProducing = activeProducers.load(memory_order_acquire) > 0;
+
+                if (queue.pop_front(item))
+                {
+                    received(consumer, item);
+                }
+                else if (!isProducing)
+                {
+                    break;
+                }
+                else
+                {
+                    this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (thread &worker : threads)
+    {
+        worker.join();
+    }
+}
+
+/// @brief Checks that every item pushed to a small ConcurrentQueue by several threads
+/// is popped exactly once, and that the items of one producer are popped in order
+/// @return true if the queue passed
+bool stressConcurrentQueue()
+{
+    const int producerCount = 4;
+    const int consumerCount = 4;
+    const long long itemCount = 400000;
+
+    // a small queue is full & empty all the time and wraps around thousands of times
+    ConcurrentQueue<long long> queue(16);
+
+    vector<char> isReceived(itemCount, false);
+    atomic<bool> isValid(true);
+
+    // last item number popped by every consumer from every producer
+    vector<vector<long long>> lastReceived(consumerCount, vector<long long>(producerCount, -1));
+
+    passItems(queue, producerCount, consumerCount, itemCount, [&](int consumer, long long item) {
+        long long number = item >> 8;
+        int producer = item & 0xFF;
+
+        if (number < 0 || number >= itemCount || isReceived[number] || number <= lastReceived[consumer][producer])
+        {
+            isValid = false;
+            return;
+        }
+
+        isReceived[number] = true;
+        lastReceived[consumer][producer] = number;
+    });
+
+    return isValid && count(isReceived.begin(), isReceived.end(), true) == itemCount && queue.is_empty();
+}
+
+void benchmarkConcurrentQueue()
+{
+    printGroup("Queues between threads (per item)");
+
+    if (!stressConcurrentQueue())
+    {
+        cout << "[ERROR] ConcurrentQueue lost, duplicated or reordered items\n";
+        exit(1);
+    }
+
+    const int capacity = 1024;
+
+    for (int threadCount : {1, 2, 4})
+    {
+        string threads = to_string(threadCount) + " producer(s), " + to_string(threadCount) + " consumer(s)";
+
+        measure("ConcurrentQueue, " + threads, [&](long long n) {
+            ConcurrentQueue<long long> queue(capacity);
+            passItems(queue, threadCount, threadCount, n, [](int, long long item) { benchmarkSink += item; });
+        });
+
+        measure("mutex + Deque, " + threads, [&](long long n) {
+            LockedQueue<long long> queue(capacity);
+            passItems(queue, threadCount, threadCount, n, [](int, long long item) { benchmarkSink += item; });
+        });
+    }
+}
+
+void benchmarkBoardRefresh()
+{
+    printGroup("Board::refresh");
+
+    for (int size : {20, 50, 100})
+    {
+        for (int density : {1, 5, 20})
+        {
+            int robotCount = size * size * density / 100;
+            populateBoard(size, size, robotCount, 1);
+
+            Board board;
+            measure(to_string(size) + "x" + to_string(size) + ", " + to_string(robotCount) + " robots (" + to_string(density) + "%)", [&](long long n) {
+                for (long long i = 0; i < n; i++)
+                    board.refresh();
+            });
+
+            clearBoard();
+        }
+    }
+
+    // A board far larger than a terminal, drawn from captured robots so only the drawing is
+    // measured. Filling a buffer of the same size with memset is about the fastest it could be drawn
+    for (int robotCount : {16000, 160000, 1600000})
+    {
+        populateBoard(4000, 4000, robotCount, 1);
+
+        Board board;
+        vector<BoardRobot> robots;
+        Board::captureRobots(robots);
+
+        string suffix = ", " + to_string(robotCount) + " robots";
+        string frame((size_t)4003 * 4002, ' ');
+
+        measure("4000x4000 frame, memset only" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+            {
+                memset(&frame[0], (int)i, frame.size());
+                benchmarkSink = benchmarkSink + frame[i % frame.size()];
+            }
+        });
+
+        measure("4000x4000" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                board.refresh(robots);
+        });
+
+        clearBoard();
+    }
+}
+
+void benchmarkBoardViews()
+{
+    printGroup("Board views (2000x2000)");
+
+    for (int robotCount : {1000, 100000})
+    {
+        populateBoard(2000, 2000, robotCount, 1);
+
+        Board board;
+        vector<BoardRobot> robots;
+        Board::captureRobots(robots);
+
+        string suffix = ", " + to_string(robotCount) + " robots";
+
+        measure("80x40 window" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                board.refreshWindow(robots, 960, 980, 80, 40);
+        });
+
+        measure("80x40 overview" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                board.refreshOverview(robots, 80, 40);
+        });
+
+        clearBoard();
+    }
+}
+
+void benchmarkTerminalOutput()
+{
+    printGroup("TerminalScreen::update");
+
+    populateBoard(200, 100, 1000, 1);
+
+    Board board;
+    board.refresh();
+    string frame = board.getBoard();
+
+    // the same board with 20 robots moved by one cell
+    string movedFrame = frame;
+    int rowLength = 200 + 3;
+    int moved = 0;
+
+    for (size_t i = rowLength; i + 1 < movedFrame.size() && moved < 20; i++)
+    {
+        if (movedFrame[i] == 'R' && movedFrame[i + 1] == ' ')
+        {
+            swap(movedFrame[i], movedFrame[i + 1]);
+            moved++;
+            i += rowLength;
+        }
+    }
+
+    TerminalScreen screen;
+    long long outputBytes = 0;
+
+    measure("200x100, 20 robots moved", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+            outputBytes += screen.update(i % 2 == 0 ? movedFrame : frame, 0).size();
+    });
+
+    benchmarkSink = outputBytes;
+
+    clearBoard();
+}
+
+void benchmarkLog()
+{
+    printGroup("Log");
+
+    Log actionLog;
+    auto resetLog = [&]() { actionLog.resetLog(); };
+
+    measure("Log::enemySpotted", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::enemySpotted("Kid", "Jet", 12, 34);
+    }, resetLog);
+
+    measure("Log::move", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::move("Kid", 12, 34);
+    }, resetLog);
+
+    measure("Log::trample", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::trample("Kid", "Jet");
+    }, resetLog);
+
+    measure("Log::fire", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::fire("Kid", 12, 34);
+    }, resetLog);
+
+    measure("Log::fireHit", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::fireHit("Kid", "Jet");
+    }, resetLog);
+
+    measure("Log::evolve", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::evolve("Kid", "TerminatorRoboCop");
+    }, resetLog);
+
+    measure("Log::revive", [](long long n) {
+        for (long long i = 0; i < n; i++)
+            Log::revive("Kid", 12, 34);
+    }, resetLog);
+}
+
+void benchmarkRandomNumbers()
+{
+    printGroup("Random numbers (50x50 board)");
+
+    RNG::init(50, 50);
+
+    measure("RNG::posX, mt19937", [](long long n) {
+        RNG::seed(3);
+        for (long long i = 0; i < n; i++)
+            benchmarkSink = benchmarkSink + RNG::posX();
+    });
+
+    measure("RNG::posX, random streams", [](long long n) {
+        RNG::seedStreams(3, 0);
+        for (long long i = 0; i < n; i++)
+            benchmarkSink = benchmarkSink + RNG::posX();
+    });
+
+    // A board-wide shooter used to draw every target as two integers with a distribution each
+    measure("cell, RNG::integer x2", [](long long n) {
+        RNG::seed(3);
+        for (long long i = 0; i < n; i++)
+            benchmarkSink = benchmarkSink + RNG::integer(-10, 39) + RNG::integer(-20, 29);
+    });
+
+    measure("cell, RNG::cells (3 per call)", [](long long n) {
+        RNG::seed(3);
+        int cellX[3];
+        int cellY[3];
+        for (long long i = 0; i < n; i += 3)
+        {
+            RNG::cells(3, cellX, cellY);
+            benchmarkSink = benchmarkSink + cellX[0] + cellY[2];
+        }
+    });
+
+    measure("cell, RNG::cells (64 per call)", [](long long n) {
+        RNG::seed(3);
+        int cellX[64];
+        int cellY[64];
+        for (long long i = 0; i < n; i += 64)
+        {
+            RNG::cells(64, cellX, cellY);
+            benchmarkSink = benchmarkSink + cellX[0] + cellY[63];
+        }
+    });
+
+    measure("cell, RNG::cells (64 per call), random streams", [](long long n) {
+        RNG::seedStreams(3, 0);
+        int cellX[64];
+        int cellY[64];
+        for (long long i = 0; i < n; i += 64)
+        {
+            RNG::cells(64, cellX, cellY);
+            benchmarkSink = benchmarkSink + cellX[0] + cellY[63];
+        }
+    });
+
+    // A robot typically draws a handful of numbers from every stream it selects
+    measure("RNG::selectStream + 4 draws", [](long long n) {
+        RNG::seedStreams(3, 0);
+        for (long long i = 0; i < n; i++)
+        {
+            RNG::selectStream(i >> 10, i & 1023);
+            for (int draw = 0; draw < 4; draw++)
+                benchmarkSink = benchmarkSink + RNG::posX();
+        }
+    });
+
+    RNG::seed(3);
+}
+
+void benchmarkRobotQueries()
+{
+    printGroup("Robot queries (50x50 board)");
+
+    Log actionLog;
+
+    for (int robotCount : {25, 125, 500})
+    {
+        populateBoard(50, 50, robotCount, 2);
+        RNG::seed(2);
+
+        // The 5x5 area around the center is kept empty by populateBoard(),
+        // so every query below misses and leaves the board unchanged
+        RoboCop subject("Subject", 25, 25);
+        string suffix = ", " + to_string(robotCount) + " robots";
+
+        measure("look (empty cell)" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                subject.look(1, 1);
+        }, [&]() { actionLog.resetLog(); });
+
+        measure("fire (miss)" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                subject.fire(-2, 1);
+        }, [&]() { actionLog.resetLog(); });
+
+        measure("move (there and back)" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                subject.move((i & 1) ? -1 : 1, 0);
+        }, [&]() {
+            actionLog.resetLog();
+            subject.updatePositionX(25);
+        });
+
+        // Targeted fire searches the index of occupied cells within the fire range,
+        // and hunting searches it for the nearest robot
+        SpatialIndex occupiedCells;
+        occupiedCells.reset(50, 50, robotCount);
+        for (int i = 0; i < Robot::robotDeque.size(); i++)
+        {
+            occupiedCells.insert(Robot::robotDeque[i]->getPositionX(), Robot::robotDeque[i]->getPositionY(), i);
+        }
+
+        Robot::occupiedCells = &occupiedCells;
+        Robot::isTargetedFire = true;
+
+        measure("aimAtRobots (3 shots, range 10)" + suffix, [&](long long n) {
+            int targetX[3];
+            int targetY[3];
+            for (long long i = 0; i < n; i++)
+                benchmarkSink = benchmarkSink + subject.aimAtRobots(targetX, targetY, 3);
+        });
+
+        Terminator hunter("Hunter", 25, 25);
+
+        measure("findNearestRobots (4 nearest)" + suffix, [&](long long n) {
+            SpatialEntry found[4];
+            for (long long i = 0; i < n; i++)
+                benchmarkSink = benchmarkSink + hunter.findNearestRobots(4, found);
+        });
+
+        Robot::occupiedCells = nullptr;
+        Robot::isTargetedFire = false;
+
+        // With a bitboard of occupied cells, looking at & firing at an empty cell skip the robots
+        Bitboard occupiedBits;
+        occupiedBits.reset(50, 50);
+        for (int i = 0; i < Robot::robotDeque.size(); i++)
+        {
+            occupiedBits.set(Robot::robotDeque[i]->getPositionX(), Robot::robotDeque[i]->getPositionY());
+        }
+
+        Robot::occupiedBits = &occupiedBits;
+
+        measure("look (empty cell, bitboard)" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                subject.look(1, 1);
+        }, [&]() { actionLog.resetLog(); });
+
+        measure("fire (miss, bitboard)" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                subject.fire(-2, 1);
+        }, [&]() { actionLog.resetLog(); });
+
+        Robot::occupiedBits = nullptr;
+
+        clearBoard();
+    }
+}
+
+void benchmarkBitboard()
+{
+    printGroup("Bitboard (4000x4000 board)");
+
+    for (int robotCount : {1600, 160000})
+    {
+        Bitboard cells;
+        cells.reset(4000, 4000);
+
+        mt19937 generator(4);
+        for (int i = 0; i < robotCount; i++)
+        {
+            cells.set(generator() % 4000, generator() % 4000);
+        }
+
+        string suffix = ", " + to_string(robotCount) + " robots";
+
+        for (bool isAvx2 : {false, true})
+        {
+            if (isAvx2 && !Bitboard::hasAvx2())
+                continue;
+
+            Bitboard::setAvx2Enabled(isAvx2);
+            string kind = isAvx2 ? " (AVX2)" : " (portable)";
+
+            measure("countClear" + kind + suffix, [&](long long n) {
+                for (long long i = 0; i < n; i++)
+                    benchmarkSink = benchmarkSink + cells.countClear();
+            });
+        }
+
+        Bitboard::setAvx2Enabled(true);
+
+        measure("findNthClear" + suffix, [&](long long n) {
+            int posX = 0;
+            int posY = 0;
+            for (long long i = 0; i < n; i++)
+            {
+                if (cells.findNthClear((i * 7919) % cells.countClear(), posX, posY))
+                    benchmarkSink = benchmarkSink + posX + posY;
+            }
+        });
+
+        measure("isAnyNeighbourSet" + suffix, [&](long long n) {
+            for (long long i = 0; i < n; i++)
+                benchmarkSink = benchmarkSink + cells.isAnyNeighbourSet((i * 7919) % 4000, (i * 104729) % 4000);
+        });
+    }
+}
+
+void benchmarkConfigLoading()
+{
+    printGroup("Config loading (per robot)");
+
+    for (int robotCount : {1000, 100000})
+    {
+        ScenarioGenerator generator;
+        generator.width = 1000;
+        generator.height = 1000;
+        generator.robotCount = robotCount;
+        generator.typeMix = {{"RoboCop", 1}, {"Terminator", 1}, {"BlueThunder", 1}, {"Madbot", 1}};
+        generator.seed = 4;
+
+        string config = generator.generate();
+        string suffix = ", " + to_string(robotCount) + " robots";
+
+        measure("ConfigParser" + suffix, [&](long long n) {
+            long long robotsParsed = 0;
+
+            while (robotsParsed < n)
+            {
+                ConfigParser parser(config);
+                ConfigParser::RobotEntry entry;
+                parser.parseHeader();
+
+                while (parser.nextRobot(entry))
+                {
+                    robotsParsed++;
+                }
+            }
+        });
+
+        // Loading from memory, as a text config and as a binary scenario, as generated configs are
+        string scenario;
+        {
+            ostringstream scenarioStream;
+            ScenarioWriter::convert(config, scenarioStream);
+            scenario = scenarioStream.str();
+        }
+
+        for (const auto &contents : {pair<string, const string *>{"text config", &config}, {"binary scenario", &scenario}})
+        {
+            InMemoryConfig inMemoryConfig{*contents.second};
+
+            measure("Game construction, " + contents.first + suffix, [&](long long n) {
+                long long robotsLoaded = 0;
+
+                while (robotsLoaded < n)
+                {
+                    Game game(inMemoryConfig, true);
+                    robotsLoaded += robotCount;
+                }
+            });
+        }
+    }
+}
+
+void benchmarkGames()
+{
+    printGroup("Full game turns (50x50 board, 40 robots, up to 200 turns)");
+
+    const vector<pair<string, vector<string>>> mixes = {
+        {"RoboCop", {"RoboCop"}},
+        {"Terminator", {"Terminator"}},
+        {"TerminatorRoboCop", {"TerminatorRoboCop"}},
+        {"BlueThunder", {"BlueThunder"}},
+        {"Madbot", {"Madbot"}},
+        {"RoboTank", {"RoboTank"}},
+        {"UltimateRobot", {"UltimateRobot"}},
+        {"Nemesis", {"Nemesis"}},
+        {"mixed", {"RoboCop", "Terminator", "BlueThunder", "Madbot", "RoboTank"}},
+    };
+
+    for (const auto &mix : mixes)
+    {
+        ScenarioGenerator generator;
+        generator.width = 50;
+        generator.height = 50;
+        generator.turns = 200;
+        generator.robotCount = 40;
+        generator.seed = 3;
+        generator.typeMix.clear();
+        for (const string &type : mix.second)
+        {
+            generator.typeMix.push_back({type, 1});
+        }
+
+        string config = generator.generate();
+
+        // The mixed game is also played with the display on a render thread, with only
+        // the final turn displayed, with counter-based random streams and with targeted fire
+        for (const string variant : {"", ", render thread", ", final frame only", ", random streams", ", targeted fire"})
+        {
+            if (!variant.empty() && mix.first != "mixed")
+            {
+                continue;
+            }
+
+            measure("turn, " + mix.first + variant, [&](long long n) {
+                int originalStdout = discardStdout();
+
+                // Games are restarted from turn 0 whenever one ends so that
+                // exactly n turns are measured
+                while (n > 0)
+                {
+                    if (variant == ", random streams")
+                    {
+                        RNG::seedStreams(3, 0);
+                    }
+                    else
+                    {
+                        RNG::seed(3);
+                    }
+
+                    Game game(InMemoryConfig{config});
+
+                    if (variant == ", render thread")
+                    {
+                        game.startRenderThread();
+                    }
+                    else if (variant == ", final frame only")
+                    {
+                        game.setRenderPolicy(RenderPolicy::finalOnly());
+                    }
+                    else if (variant == ", targeted fire")
+                    {
+                        game.setTargetedFire(true);
+                    }
+
+                    while (game.isValidState() && n > 0)
+                    {
+                        game.nextTurn();
+                        n--;
+                    }
+                }
+
+                restoreStdout(originalStdout);
+            });
+        }
+    }
+
+    RNG::seed(3);
+}
+
+void benchmarkForking()
+{
+    printGroup("Branching a game at turn 100 (200x200 board, 1000 robots, per branch)");
+
+    ScenarioGenerator generator;
+    generator.width = 200;
+    generator.height = 200;
+    generator.turns = 1000;
+    generator.robotCount = 1000;
+    generator.typeMix = {{"RoboCop", 1}, {"Terminator", 1}, {"BlueThunder", 1}, {"Madbot", 1}};
+    generator.seed = 6;
+
+    const int branchTurn = 100;
+    const string config = generator.generate();
+
+    measure("replay from turn 0", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            RNG::seed(6);
+            Game game(InMemoryConfig{config}, true);
+
+            while (game.getTurn() < branchTurn)
+            {
+                game.nextTurn();
+            }
+        }
+    });
+
+    GameState branchState;
+    {
+        RNG::seed(6);
+        Game game(InMemoryConfig{config}, true);
+
+        while (game.getTurn() < branchTurn)
+        {
+            game.nextTurn();
+        }
+
+        branchState = game.getState();
+    }
+
+    measure("GameState::fork", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            GameState branch = branchState.fork((unsigned int)i);
+            benchmarkSink += branch.robots.size();
+        }
+    });
+
+    measure("Game construction from a fork", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            Game game(branchState.fork((unsigned int)i), true);
+        }
+    });
+}
+
+/// @brief Measures looking at the 8 cells around every robot, as robots do when they decide a simultaneous turn.
+/// The robots are placed in random order, so in robot queue order neighbouring robots are far apart in memory
+void benchmarkNeighbourhoodLookups(int width, int height, int robotCount)
+{
+    printGroup("Neighbourhood lookups (" + to_string(width) + "x" + to_string(height) + " board, " + to_string(robotCount) + " robots, per robot)");
+
+    populateBoard(width, height, robotCount, 5);
+
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    // The cells hashed into a map, the way views were stored before they were laid out along a curve
+    unordered_map<long long, Robot *> hashedCells;
+    hashedCells.reserve(robots.size());
+
+    // Every operation adds one robot, the map being rebuilt from scratch every robots.size() operations
+    measure("build hashed cells", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            int j = i % robots.size();
+
+            if (j == 0)
+            {
+                hashedCells.clear();
+            }
+
+            hashedCells.insert({TurnView::cellKey(robots[j]->getPositionX(), robots[j]->getPositionY()), robots[j]});
+        }
+    });
+
+    TurnView view;
+
+    measure("build Hilbert tiles", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            int j = i % robots.size();
+
+            if (j == 0)
+            {
+                view.reset(TurnStreams(), 0, height - 1, robots.size(), nullptr);
+            }
+
+            view.add(robots[j], j);
+
+            if (j == robots.size() - 1)
+            {
+                view.arrange();
+            }
+        }
+    });
+
+    // the lookups below need every robot in the map & the view
+    hashedCells.clear();
+    view.reset(TurnStreams(), 0, height - 1, robots.size(), nullptr);
+
+    for (int j = 0; j < robots.size(); j++)
+    {
+        hashedCells.insert({TurnView::cellKey(robots[j]->getPositionX(), robots[j]->getPositionY()), robots[j]});
+        view.add(robots[j], j);
+    }
+
+    view.arrange();
+
+    // Counts the robots in the 8 cells around a cell
+    auto lookAround = [&](int posX, int posY, auto occupant) {
+        int seen = 0;
+
+        for (int i = -1; i <= 1; i++)
+        {
+            for (int j = -1; j <= 1; j++)
+            {
+                if ((i != 0 || j != 0) && TurnView::isInside(posX + i, posY + j) && occupant(posX + i, posY + j) != nullptr)
+                    seen++;
+            }
+        }
+
+        return seen;
+    };
+
+    auto hashedOccupant = [&](int posX, int posY) {
+        auto occupant = hashedCells.find(TurnView::cellKey(posX, posY));
+        return occupant == hashedCells.end() ? nullptr : occupant->second;
+    };
+
+    auto viewOccupant = [&](int posX, int posY) {
+        return view.occupant(posX, posY);
+    };
+
+    measure("hashed cells, robot queue order", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            Robot *robot = robots[i % robots.size()];
+            benchmarkSink = benchmarkSink + lookAround(robot->getPositionX(), robot->getPositionY(), hashedOccupant);
+        }
+    });
+
+    measure("Hilbert tiles, robot queue order", [&](long long n) {
+        for (long long i = 0; i < n; i++)
+        {
+            Robot *robot = robots[i % robots.size()];
+            benchmarkSink = benchmarkSink + lookAround(robot->getPositionX(), robot->getPositionY(), viewOccupant);
+        }
+    });
+
+    measure("Hilbert tiles, curve order", [&](long long n) {
+        while (n > 0)
+        {
+            view.forEachRobot([&](const TurnView::Entry &entry) {
+                if (n-- > 0)
+                    benchmarkSink = benchmarkSink + lookAround(entry.posX, entry.posY, viewOccupant);
+            });
+        }
+    });
+
+    clearBoard();
+}
+
+/// @param isSequentialMeasured true to also measure the normal rules, which are too slow for large boards
+void benchmarkSimultaneousTurns(int width, int height, int robotCount, bool isSequentialMeasured)
+{
+    printGroup("Simultaneous turns (" + to_string(width) + "x" + to_string(height) + " board, " + to_string(robotCount) + " robots, per turn)");
+
+    ScenarioGenerator generator;
+    generator.width = width;
+    generator.height = height;
+    generator.turns = 1000;
+    generator.robotCount = robotCount;
+    generator.typeMix = {{"RoboCop", 3}, {"Terminator", 2}, {"BlueThunder", 1}, {"Madbot", 1}, {"RoboTank", 1}};
+    generator.seed = 7;
+
+    GameState startState;
+    {
+        string config = generator.generate();
+
+        RNG::seed(7);
+        Game game(InMemoryConfig{config}, true);
+        startState = game.getState();
+    }
+
+    // threadCount 0 plays the normal rules
+    vector<int> threadCounts = {1};
+    if (isSequentialMeasured)
+    {
+        threadCounts.insert(threadCounts.begin(), 0);
+    }
+    if (thread::hardware_concurrency() > 1)
+    {
+        threadCounts.push_back(thread::hardware_concurrency());
+    }
+
+    for (int threadCount : threadCounts)
+    {
+        string name = threadCount == 0 ? "robots acting one after another" : "simultaneous, " + to_string(threadCount) + " thread(s)";
+
+        measure(name, [&](long long n) {
+            // Games are restarted whenever one ends so that exactly n turns are measured
+            while (n > 0)
+            {
+                Game game(startState, true);
+                game.setSimultaneousTurns(threadCount != 0, threadCount);
+
+                while (game.isValidState() && n > 0)
+                {
+                    game.nextTurn();
+                    n--;
+                }
+            }
+        });
+    }
+}
+
+void benchmarkBatchGames()
+{
+    const int gameCount = 32;
+
+    printGroup("Batch of " + to_string(gameCount) + " games of mixed length (per batch)");
+
+    // RoboTank free-for-alls end within a few dozen turns, BlueThunders rarely hit each other and play to the turn limit
+    ScenarioGenerator shortGame;
+    shortGame.width = 10;
+    shortGame.height = 10;
+    shortGame.turns = 2000;
+    shortGame.robotCount = 30;
+    shortGame.typeMix = {{"RoboTank", 1}};
+    shortGame.seed = 8;
+
+    ScenarioGenerator longGame = shortGame;
+    longGame.width = 60;
+    longGame.height = 60;
+    longGame.robotCount = 10;
+    longGame.typeMix = {{"BlueThunder", 1}};
+
+    vector<int> threadCounts = {1};
+    if (thread::hardware_concurrency() > 1)
+    {
+        threadCounts.push_back(thread::hardware_concurrency());
+    }
+
+    for (int threadCount : threadCounts)
+    {
+        BatchRunner runner(threadCount);
+
+        measure("work stealing, " + to_string(threadCount) + " thread(s)", [&](long long n) {
+            for (long long i = 0; i < n; i++)
+            {
+                // the long games are submitted together, so that dealing them out in turn piles them onto a few workers
+                for (int game = 0; game < gameCount; game++)
+                {
+                    runner.submit(game < gameCount / 4 ? longGame : shortGame, game);
+                }
+
+                BatchResult result;
+                while (runner.nextResult(result))
+                {
+                    benchmarkSink += result.turn;
+                }
+            }
+        });
+    }
+}
+
+int main()
+{
+    cout << "Game engine benchmarks\n";
+
+    benchmarkDeque();
+    benchmarkConcurrentQueue();
+    benchmarkBoardRefresh();
+    benchmarkBoardViews();
+    benchmarkTerminalOutput();
+    benchmarkLog();
+    benchmarkRandomNumbers();
+    benchmarkRobotQueries();
+    benchmarkBitboard();
+    benchmarkConfigLoading();
+    benchmarkGames();
+    benchmarkForking();
+    benchmarkNeighbourhoodLookups(200, 200, 2000);
+    benchmarkNeighbourhoodLookups(2000, 2000, 100000);
+    benchmarkNeighbourhoodLookups(6000, 6000, 1000000);
+    benchmarkSimultaneousTurns(200, 200, 2000, true);
+    benchmarkSimultaneousTurns(2000, 2000, 100000, false);
+    benchmarkBatchGames();
+
+    return 0;
+}
@@ -0,0 +1,292 @@
+/*
+ *
+ * This file contains the Bitboard class that keeps one bit for every cell of
+ * the board, set where a robot stands
+ *
+ * --- Code Summary ---
+ * Every row of the board is stored in whole 64-bit words, the bits past the
+ * last column always clear, so a cell is found with a shift & a mask and the
+ * cells around it are 3 rows of 3 bits. Questions about many cells at once
+ * become a few operations per 64 cells:
+ *   - whether any of the 8 cells around a cell is occupied
+ *   - how many cells are occupied or free, and which is the nth free cell
+ *
+ * Counting the occupied cells is done 256 bits at a time with AVX2 on
+ * processors that have it. Whether they do is checked once, when the program
+ * starts, and every other processor (or compiler) uses the portable version,
+ * which gives the same results.
+ *
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BITBOARD_AVX2
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+class Bitboard
+{
+private:
+    int width = 0;
+    int height = 0;
+
+    /// @brief number of words every row is stored in
+    int wordsPerRow = 0;
+
+    /// @brief the cells row by row, bit x % 64 of word x / 64 of a row standing for column x
+    vector<uint64_t> words;
+
+    /// @brief true if the AVX2 versions of the word operations are used
+    static bool isAvx2Enabled;
+
+    static long long countBitsScalar(const uint64_t *words, int count);
+
+#ifdef BITBOARD_AVX2
+    static long long countBitsAvx2(const uint64_t *words, int count);
+#endif
+
+    /// @return the number of bits set in words[0, count)
+    static long long countBits(const uint64_t *words, int count);
+
+public:
+    /// @return true if the processor running the program supports AVX2
+    static bool hasAvx2();
+
+    /// @brief Chooses between the AVX2 & portable word operations, e.g. to compare them.
+    /// AVX2 is only used if the processor supports it
+    static void setAvx2Enabled(bool isEnabled);
+    static bool getAvx2Enabled();
+
+    /// @brief Clears every cell and sizes the bitboard for a board
+    void reset(int width, int height);
+
+    int getWidth() const;
+    int getHeight() const;
+
+    void set(int posX, int posY);
+    void clear(int posX, int posY);
+    bool test(int posX, int posY) const;
+
+    /// @return true if any of the 8 cells around a cell is occupied. Cells outside the board count as empty
+    bool isAnyNeighbourSet(int posX, int posY) const;
+
+    /// @return the number of occupied cells
+    long long countSet() const;
+
+    /// @return the number of free cells
+    long long countClear() const;
+
+    /// @brief Finds the nth free cell, counting row by row from 0
+    /// @param n number of free cells before the one to find
+    /// @param posX receives the X position of the cell
+    /// @param posY receives the Y position of the cell
+    /// @return false if there are no more than n free cells
+    bool findNthClear(long long n, int &posX, int &posY) const;
+};
+
+bool Bitboard::isAvx2Enabled = Bitboard::hasAvx2();
+
+inline bool Bitboard::hasAvx2()
+{
+#ifdef BITBOARD_AVX2
+    // may run before the constructors that would otherwise detect the processor's features
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+inline void Bitboard::setAvx2Enabled(bool isEnabled)
+{
+    isAvx2Enabled = isEnabled && hasAvx2();
+}
+
+inline bool Bitboard::getAvx2Enabled()
+{
+    return isAvx2Enabled;
+}
+
+inline long long Bitboard::countBitsScalar(const uint64_t *words, int count)
+{
+    long long bits = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        bits += __builtin_popcountll(words[i]);
+    }
+
+    return bits;
+}
+
+#ifdef BITBOARD_AVX2
+
+/// @details Counts the bits of every byte with a 16-entry table looked up by each half of
+/// the byte, and adds the counts of 8 bytes at a time into 4 running 64-bit totals
+__attribute__((target("avx2"))) inline long long Bitboard::countBitsAvx2(const uint64_t *words, int count)
+{
+    const __m256i nibbleBits = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+
+    __m256i totals = _mm256_setzero_si256();
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(words + i));
+
+        __m256i low = _mm256_shuffle_epi8(nibbleBits, _mm256_and_si256(block, lowNibbles));
+        __m256i high = _mm256_shuffle_epi8(nibbleBits, _mm256_and_si256(_mm256_srli_epi64(block, 4), lowNibbles));
+
+        totals = _mm256_add_epi64(totals, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+    }
+
+    long long bits = _mm256_extract_epi64(totals, 0) + _mm256_extract_epi64(totals, 1) +
+                     _mm256_extract_epi64(totals, 2) + _mm256_extract_epi64(totals, 3);
+
+    return bits + countBitsScalar(words + i, count - i);
+}
+
+#endif
+
+inline long long Bitboard::countBits(const uint64_t *words, int count)
+{
+#ifdef BITBOARD_AVX2
+    if (isAvx2Enabled)
+    {
+        return countBitsAvx2(words, count);
+    }
+#endif
+
+    return countBitsScalar(words, count);
+}
+
+inline void Bitboard::reset(int width, int height)
+{
+    this->width = width;
+    this->height = height;
+    wordsPerRow = (width + 63) / 64;
+
+    // the words keep their memory when the bitboard is reset for another turn
+    words.assign((size_t)wordsPerRow * height, 0);
+}
+
+inline int Bitboard::getWidth() const
+{
+    return width;
+}
+
+inline int Bitboard::getHeight() const
+{
+    return height;
+}
+
+inline void Bitboard::set(int posX, int posY)
+{
+    words[(size_t)posY * wordsPerRow + (posX >> 6)] |= 1ULL << (posX & 63);
+}
+
+inline void Bitboard::clear(int posX, int posY)
+{
+    words[(size_t)posY * wordsPerRow + (posX >> 6)] &= ~(1ULL << (posX & 63));
+}
+
+inline bool Bitboard::test(int posX, int posY) const
+{
+    return (words[(size_t)posY * wordsPerRow + (posX >> 6)] >> (posX & 63)) & 1;
+}
+
+inline bool Bitboard::isAnyNeighbourSet(int posX, int posY) const
+{
+    // the 3 columns around posX, taken from the word holding posX and, at the edges of
+    // the word, from the word before or after it
+    int word = posX >> 6;
+    int bit = posX & 63;
+
+    for (int y = posY - 1; y <= posY + 1; y++)
+    {
+        if (y < 0 || y >= height)
+            continue;
+
+        const uint64_t *row = words.data() + (size_t)y * wordsPerRow;
+
+        uint64_t columns = (row[word] >> bit) << 1;
+
+        if (bit > 0)
+            columns |= row[word] >> (bit - 1) & 1;
+        else if (word > 0)
+            columns |= row[word - 1] >> 63;
+
+        if (bit == 63 && word + 1 < wordsPerRow)
+            columns |= (row[word + 1] & 1) << 2;
+
+        // the cell itself is not one of its neighbours
+        uint64_t mask = y == posY ? 0b101 : 0b111;
+
+        if (columns & mask)
+            return true;
+    }
+
+    return false;
+}
+
+inline long long Bitboard::countSet() const
+{
+    return countBits(words.data(), words.size());
+}
+
+inline long long Bitboard::countClear() const
+{
+    return (long long)width * height - countSet();
+}
+
+inline bool Bitboard::findNthClear(long long n, int &posX, int &posY) const
+{
+    for (int y = 0; y < height; y++)
+    {
+        const uint64_t *row = words.data() + (size_t)y * wordsPerRow;
+        long long rowClear = width - countBits(row, wordsPerRow);
+
+        if (n >= rowClear)
+        {
+            n -= rowClear;
+            continue;
+        }
+
+        for (int word = 0; word < wordsPerRow; word++)
+        {
+            // the free cells of the word, leaving out the bits past the last column
+            uint64_t free = ~row[word];
+            if (word == wordsPerRow - 1 && width % 64 != 0)
+                free &= (1ULL << (width % 64)) - 1;
+
+            int wordClear = __builtin_popcountll(free);
+
+            if (n >= wordClear)
+            {
+                n -= wordClear;
+                continue;
+            }
+
+            // drop the n lowest free cells of the word
+            for (; n > 0; n--)
+                free &= free - 1;
+
+            posX = word * 64 + __builtin_ctzll(free);
+            posY = y;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
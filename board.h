@@ -7,17 +7,33 @@
  * The code iterates through robotDeque to and stores all robots' first letter
  * in their name, X position & Y position in an array for fast lookups.
  *
- * Then, as the board is being generated, these arrays are referenced to check
- * whether robots are located in a particular position on the board
+ * Then the robots are sorted by row, and the whole board is written into a
+ * buffer sized once for it: every row is filled with empty space and the letter
+ * of every robot in the row is written over it, the row being in the cache
+ * while it is drawn. On boards too large for the cache this keeps drawing the
+ * board close to the time it takes to fill the buffer
+ *
+ * The robots can also be captured first and drawn later, which lets the
+ * board of one turn be drawn on another thread while the next turn is played.
+ *
+ * Boards too large to read in a terminal can be drawn as a window showing only
+ * part of the board, or as an overview where every character stands for a
+ * block of cells and shows how many robots are in it. Both take time
+ * proportional to the size of the output and the number of robots, not the
+ * size of the board.
  *
  */
 
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <climits>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "robotbase.h"
+#include "tracer.h"
 
 using namespace std;
 
@@ -36,13 +52,46 @@ string repeatChar(const char character, const int numberOfTimes)
     return temp;
 }
 
+/// @brief datatype for storing a robot's first letter char,
+/// X coordinate & Y coordinate, which is all the board needs to draw a robot
+struct BoardRobot
+{
+    char firstChar;
+    int positionX;
+    int positionY;
+};
+
 class Board
 {
 private:
-    static int width;
-    static int height;
+    /// @brief size of the board of the game played on this thread. Threads
+    /// working for that game are given it with setSize()
+    static thread_local int width;
+    static thread_local int height;
     string boardBuffer = "";
 
+    /// @brief robots read from robotDeque by refresh(), kept to reuse its memory
+    vector<BoardRobot> robotInfo;
+
+    /// @brief the X position & letter of a robot in a row of the board
+    struct RowRobot
+    {
+        int positionX;
+        char firstChar;
+    };
+
+    /// @brief the robots drawn by refresh() sorted by row: those of row y are
+    /// rowRobots[rowStart[y], rowStart[y + 1]), in the order they were given in
+    vector<int> rowStart;
+    vector<RowRobot> rowRobots;
+
+    /// @brief index of the robot drawn on every cell of the window, or the
+    /// number of robots in every block of the overview
+    vector<int> cells;
+
+    void appendHorizontalBorder(int length);
+    void drawHorizontalBorder(char *line, int length);
+
 
     /*---------------------------------------------*/
     /*              Board Characters               */
@@ -61,7 +110,7 @@ public:
 
     static int getWidth();
     static int getHeight();
-    string getBoard() const;
+    const string &getBoard() const;
 
     /*---------------------------------------------*/
     /*                 Modifiers                   */
@@ -70,12 +119,40 @@ public:
     void setWidth(int width);
     void setHeight(int height);
 
+    /// @brief Sets the board size seen by the calling thread, e.g. a thread
+    /// helping to play or display a game started on another thread
+    static void setSize(int width, int height);
+
     /// @brief refreshes the boardBuffer with the board containing the latest robot positions
     void refresh();
+
+    /// @brief refreshes the boardBuffer with the board containing the given robots
+    /// @param robots robots to draw. Where robots share a position, the one earliest in the list is drawn
+    void refresh(const vector<BoardRobot> &robots);
+
+    /// @brief refreshes the boardBuffer with a window showing part of the board
+    /// @param robots robots to draw. Where robots share a position, the one earliest in the list is drawn
+    /// @param left X position of the leftmost column of the window
+    /// @param top Y position of the top row of the window
+    /// @param viewWidth number of columns in the window
+    /// @param viewHeight number of rows in the window
+    void refreshWindow(const vector<BoardRobot> &robots, int left, int top, int viewWidth, int viewHeight);
+
+    /// @brief refreshes the boardBuffer with an overview of the whole board, where every
+    /// character shows how many robots are in a block of cells: ' ' for none, '1' to '9',
+    /// or '#' for 10 or more
+    /// @param robots robots to count
+    /// @param columns maximum number of columns in the overview
+    /// @param rows maximum number of rows in the overview
+    void refreshOverview(const vector<BoardRobot> &robots, int columns, int rows);
+
+    /// @brief Reads the first letter & position of every robot in robotDeque
+    /// @param robots list the robots are written to, in robotDeque order
+    static void captureRobots(vector<BoardRobot> &robots);
 };
 
-int Board::width;
-int Board::height;
+thread_local int Board::width;
+thread_local int Board::height;
 
 int Board::getWidth()
 {
@@ -87,7 +164,7 @@ int Board::getHeight()
     return Board::height;
 }
 
-inline string Board::getBoard() const
+inline const string &Board::getBoard() const
 {
     return boardBuffer;
 }
@@ -102,73 +179,190 @@ inline void Board::setHeight(int height)
     Board::height = height;
 }
 
-inline void Board::refresh(/* pass in robot Queue */)
+inline void Board::setSize(int width, int height)
+{
+    Board::width = width;
+    Board::height = height;
+}
+
+inline void Board::captureRobots(vector<BoardRobot> &robots)
+{
+    int robotCount = Robot::robotDeque.size();
+    robots.resize(robotCount);
+
+    // Reading in values from robotDeque
+    for (int i = 0; i < robotCount; i++)
+    {
+        robots[i].firstChar = Robot::robotDeque[i]->getName()[0];
+        robots[i].positionX = Robot::robotDeque[i]->getPositionX();
+        robots[i].positionY = Robot::robotDeque[i]->getPositionY();
+    }
+}
+
+inline void Board::refresh()
+{
+    captureRobots(robotInfo);
+    refresh(robotInfo);
+}
+
+inline void Board::refresh(const vector<BoardRobot> &robots)
+{
+    TRACE_SCOPE("Board::refresh");
+
+    // Sort the robots by row, counting the robots of every row first. Each row is then
+    // drawn while it is in the cache, instead of every robot's cell being written to a
+    // different part of a board too large to fit in it
+    rowStart.assign(height + 1, 0);
+    rowRobots.resize(robots.size());
+
+    for (const BoardRobot &robot : robots)
+    {
+        rowStart[robot.positionY + 1]++;
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        rowStart[y + 1] += rowStart[y];
+    }
+
+    // rowStart[y] is moved to the end of row y while filling it, then back to its start
+    for (const BoardRobot &robot : robots)
+    {
+        rowRobots[rowStart[robot.positionY]++] = {robot.positionX, robot.firstChar};
+    }
+
+    for (int y = height; y > 0; y--)
+    {
+        rowStart[y] = rowStart[y - 1];
+    }
+    rowStart[0] = 0;
+
+    // Every line of the board, borders included, is '|' or '+', width cells, '|' or '+'
+    // and a newline, so the frame is sized once and every line written in place
+    size_t lineLength = (size_t)width + 3;
+    boardBuffer.resize(lineLength * (height + 2));
+    char *line = &boardBuffer[0];
+
+    drawHorizontalBorder(line, width);
+    line += lineLength;
+
+    for (int y = 0; y < height; y++)
+    {
+        line[0] = VERTICAL_BAR;
+        memset(line + 1, EMPTY_SPACE, width);
+
+        // going through the row backwards leaves the letter of the earliest robot on cells robots share
+        for (int k = rowStart[y + 1] - 1; k >= rowStart[y]; k--)
+        {
+            line[1 + rowRobots[k].positionX] = rowRobots[k].firstChar;
+        }
+
+        line[width + 1] = VERTICAL_BAR;
+        line[width + 2] = '\n';
+
+        line += lineLength;
+    }
+
+    drawHorizontalBorder(line, width);
+}
+
+inline void Board::drawHorizontalBorder(char *line, int length)
+{
+    line[0] = CORNER;
+    memset(line + 1, HORIZONTAL_BAR, length);
+    line[length + 1] = CORNER;
+    line[length + 2] = '\n';
+}
+
+inline void Board::appendHorizontalBorder(int length)
 {
-    // clear the boardBuffer
-    boardBuffer = "";
-    
-    // append the top border of the board
     boardBuffer += CORNER;
-    boardBuffer += repeatChar(HORIZONTAL_BAR, width);
+    boardBuffer.append(length, HORIZONTAL_BAR);
     boardBuffer += CORNER;
     boardBuffer += '\n';
+}
 
-    int robotCount = Robot::robotDeque.size();
+inline void Board::refreshWindow(const vector<BoardRobot> &robots, int left, int top, int viewWidth, int viewHeight)
+{
+    TRACE_SCOPE("Board::refreshWindow");
+
+    // The robots are captured for another thread to draw, so there is no index of them kept
+    // up to date to query, and building one for a single window costs more than checking
+    // every robot. The robot with the lowest index is drawn on every cell of the window
+    cells.assign(viewWidth * viewHeight, INT_MAX);
 
-    /// @brief datatype for storing a robot's first letter char,
-    /// X coordinate & Y coordinate
-    struct Info
+    for (int i = (int)robots.size() - 1; i >= 0; i--)
     {
-        char firstChar;
-        int positionX;
-        int positionY;
-    };
+        int x = robots[i].positionX - left;
+        int y = robots[i].positionY - top;
+
+        if (x >= 0 && x < viewWidth && y >= 0 && y < viewHeight)
+        {
+            cells[y * viewWidth + x] = i;
+        }
+    }
 
-    // For the sake of speed, arrays are used here to quickly look up
-    // the first letter of each robot name and robot position
+    boardBuffer = "";
+    appendHorizontalBorder(viewWidth);
 
-    /// @brief array of all robot's info
-    Info robotInfo[robotCount];
+    for (int y = 0; y < viewHeight; y++)
+    {
+        boardBuffer += VERTICAL_BAR;
 
-    // Reading in values from robotDeque
-    for (int i = 0; i < robotCount; i++)
+        for (int x = 0; x < viewWidth; x++)
+        {
+            int cell = cells[y * viewWidth + x];
+            boardBuffer += cell == INT_MAX ? EMPTY_SPACE : robots[cell].firstChar;
+        }
+
+        boardBuffer += VERTICAL_BAR;
+        boardBuffer += '\n';
+    }
+
+    appendHorizontalBorder(viewWidth);
+}
+
+inline void Board::refreshOverview(const vector<BoardRobot> &robots, int columns, int rows)
+{
+    TRACE_SCOPE("Board::refreshOverview");
+
+    // every character stands for a block of blockWidth x blockHeight cells
+    int blockWidth = (width + columns - 1) / columns;
+    int blockHeight = (height + rows - 1) / rows;
+    int overviewWidth = (width + blockWidth - 1) / blockWidth;
+    int overviewHeight = (height + blockHeight - 1) / blockHeight;
+
+    cells.assign(overviewWidth * overviewHeight, 0);
+
+    for (const BoardRobot &robot : robots)
     {
-        robotInfo[i].firstChar = Robot::robotDeque[i]->getName()[0];
-        robotInfo[i].positionX = Robot::robotDeque[i]->getPositionX();
-        robotInfo[i].positionY = Robot::robotDeque[i]->getPositionY();
+        cells[(robot.positionY / blockHeight) * overviewWidth + robot.positionX / blockWidth]++;
     }
 
-    // appending the contents of the board to boardBuffer
-    for (int y = 0; y < height; y++)
+    boardBuffer = "";
+    appendHorizontalBorder(overviewWidth);
+
+    for (int y = 0; y < overviewHeight; y++)
     {
         boardBuffer += VERTICAL_BAR;
 
-        for (int x = 0; x < width; x++)
+        for (int x = 0; x < overviewWidth; x++)
         {
-            for (int k = 0; k < robotCount; k++)
-            { // append the robot's first letter char if the x & y position
-              // matches the robot's position
-                if (robotInfo[k].positionX == x && robotInfo[k].positionY == y)
-                {
-                    boardBuffer += robotInfo[k].firstChar;
-                    break;
-                }
-                else if (k == robotCount - 1)
-                {
-                    boardBuffer += EMPTY_SPACE;
-                }
-            }
+            int count = cells[y * overviewWidth + x];
+
+            if (count == 0)
+                boardBuffer += EMPTY_SPACE;
+            else if (count < 10)
+                boardBuffer += (char)('0' + count);
+            else
+                boardBuffer += '#';
         }
 
         boardBuffer += VERTICAL_BAR;
         boardBuffer += '\n';
     }
 
-    // append the bottom border of the board
-    boardBuffer += CORNER;
-    boardBuffer += repeatChar(HORIZONTAL_BAR, width);
-    boardBuffer += CORNER;
-    boardBuffer += '\n';
+    appendHorizontalBorder(overviewWidth);
 }
 
 #endif
\ No newline at end of file
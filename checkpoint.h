@@ -0,0 +1,424 @@
+/*
+ *
+ * This file contains the GameState class that holds a complete copy of a
+ * game's state, and the binary checkpoint format it is saved in
+ *
+ * --- Code Summary ---
+ * A GameState is a flat snapshot of everything that decides how a game
+ * continues: the turn counters, the board size, every robot in the robot
+ * queue & the revive queue (in queue order) with its id, the id the next robot
+ * gets and the state of the random number generator. Game::getState() captures
+ * one between turns and a Game can be constructed from one, after which it
+ * produces exactly the same turns as the game it was captured from.
+ *
+ * GameStates are cheap to copy so that one mid-game state can be branched into
+ * many continuations: the name table is immutable and shared between all
+ * copies, and the robots are stored as flat records that are copied with a
+ * single memcpy. fork() returns such a copy that only holds the seed of its
+ * random number generator instead of the generator's full state, so every
+ * branch plays out differently from the same position.
+ *
+ * --- Checkpoint Layout ---
+ *
+ *   magic "RBCK", version
+ *   turn, turn limit, board width & height, id of the next robot created
+ *   name table: number of names, then every name as (length, characters)
+ *   robot queue: number of robots, then one RobotState record per robot
+ *   revive queue: number of robots, then one RobotState record per robot
+ *   random number generator: number of words, then every word
+ *
+ * All numbers are stored as 32 bit integers in the byte order of the machine
+ * that wrote the checkpoint.
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "random.h"
+#include "robot.h"
+
+using namespace std;
+
+const char CHECKPOINT_MAGIC[4] = {'R', 'B', 'C', 'K'};
+const int32_t CHECKPOINT_VERSION = 2;
+
+/// @brief Everything needed to recreate one robot
+struct RobotState
+{
+    RobotType type = INVALID_ROBOT_TYPE;
+
+    /// @brief the robot's id, see Robot::getId()
+    int id = 0;
+
+    /// @brief index of the robot's name in GameState::names
+    int nameIndex = 0;
+
+    int posX = 0;
+    int posY = 0;
+    int lives = 0;
+    int killsToNextEvolve = 0;
+    bool readyToEvolve = false;
+    int nextTurn = 0;
+
+    /// @brief BlueThunder's next relative fire position, unused by other robots
+    int firePositionX = 0;
+    int firePositionY = 0;
+};
+
+class GameState
+{
+public:
+    // Exception for data that is not a valid checkpoint
+    class InvalidCheckpoint
+    {
+    };
+
+    int turn = 0;
+    int turnLimit = 0;
+    int width = 0;
+    int height = 0;
+
+    /// @brief id given to the next robot created, see Robot::getNextId()
+    int nextRobotId = 0;
+
+    /// @brief names of all robots, referenced by RobotState::nameIndex.
+    /// Shared by every copy of the state
+    shared_ptr<const vector<string>> names;
+
+    /// @brief robots in Robot::robotDeque, front first
+    vector<RobotState> robots;
+
+    /// @brief robots in Robot::reviveDeque, front first
+    vector<RobotState> revivingRobots;
+
+    /// @brief state of the random number generator, see RNG::getState().
+    /// Empty if the generator is seeded with randomSeed instead
+    vector<uint32_t> randomState;
+
+    /// @brief seed of the random number generator, only used if randomState is empty
+    unsigned int randomSeed = 0;
+
+    /// @brief Copies the state for a branch that continues with different random numbers
+    /// @param seed seed of the branch's random number generator
+    /// @return the copy, sharing the name table with this state
+    GameState fork(unsigned int seed) const;
+
+    /// @brief Captures the state of one robot
+    /// @param robot the robot
+    /// @param nameIndex index of the robot's name in names
+    static RobotState captureRobot(const Robot *robot, int nameIndex);
+
+    /// @brief Creates a new robot from its saved state
+    /// @param state the saved robot
+    /// @return pointer to the new robot
+    /// @exception InvalidCheckpoint thrown if the saved robot is invalid
+    Robot *restoreRobot(const RobotState &state) const;
+
+    /// @brief Writes the state as a binary checkpoint
+    /// @param output stream to write to (opened in binary mode)
+    void write(ostream &output) const;
+
+    /// @brief Reads a binary checkpoint
+    /// @param data contents of the checkpoint
+    /// @return the saved state
+    /// @exception InvalidCheckpoint thrown if data is not a valid checkpoint
+    static GameState read(string_view data);
+
+    /// @brief Checks whether a file starts like a binary checkpoint
+    /// @param contents contents of the file
+    /// @return true if the file starts with the checkpoint magic
+    static bool isCheckpoint(string_view contents);
+};
+
+inline GameState GameState::fork(unsigned int seed) const
+{
+    GameState branch = *this;
+
+    // Seeding a generator is much cheaper than restoring its full state
+    branch.randomState = RNG::forkedState(randomState, seed);
+    branch.randomSeed = seed;
+
+    return branch;
+}
+
+inline RobotState GameState::captureRobot(const Robot *robot, int nameIndex)
+{
+    RobotState state;
+    state.type = robotTypeFromName(robot->getType());
+    state.id = robot->getId();
+    state.nameIndex = nameIndex;
+    state.posX = robot->getPositionX();
+    state.posY = robot->getPositionY();
+    state.lives = robot->getLives();
+    state.killsToNextEvolve = robot->getKillsToNextEvolve();
+    state.readyToEvolve = robot->getReadyToEvolveState();
+    state.nextTurn = robot->getNextTurn();
+
+    const BlueThunder *blueThunder = dynamic_cast<const BlueThunder *>(robot);
+    if (blueThunder != nullptr)
+    {
+        state.firePositionX = blueThunder->getFirePositionX();
+        state.firePositionY = blueThunder->getFirePositionY();
+    }
+
+    return state;
+}
+
+inline Robot *GameState::restoreRobot(const RobotState &state) const
+{
+    if (names == nullptr || state.nameIndex < 0 || state.nameIndex >= (int)names->size() ||
+        state.posX < 0 || state.posX >= width || state.posY < 0 || state.posY >= height ||
+        state.id < 0 || state.id >= nextRobotId)
+    {
+        throw InvalidCheckpoint();
+    }
+
+    Robot *robot = createRobot(state.type, (*names)[state.nameIndex], state.posX, state.posY);
+
+    if (robot == nullptr)
+    {
+        throw InvalidCheckpoint();
+    }
+
+    robot->setId(state.id);
+    robot->setLives(state.lives);
+    robot->setKillsToNextEvolve(state.killsToNextEvolve);
+    robot->setNextTurn(state.nextTurn);
+
+    if (state.readyToEvolve)
+    {
+        robot->setReadyToEvolve();
+    }
+
+    BlueThunder *blueThunder = dynamic_cast<BlueThunder *>(robot);
+    if (blueThunder != nullptr)
+    {
+        blueThunder->setFirePosition(state.firePositionX, state.firePositionY);
+    }
+
+    return robot;
+}
+
+/*---------------------------------------------*/
+/*              Binary Checkpoint              */
+/*---------------------------------------------*/
+
+/// @brief Reads values from the checkpoint data, checking that they do not run past its end
+class CheckpointReader
+{
+private:
+    string_view data;
+    size_t position = 0;
+
+public:
+    CheckpointReader(string_view data)
+    {
+        this->data = data;
+    }
+
+    int32_t readInt()
+    {
+        if (position + sizeof(int32_t) > data.size())
+        {
+            throw GameState::InvalidCheckpoint();
+        }
+
+        int32_t value;
+        memcpy(&value, data.data() + position, sizeof(value));
+        position += sizeof(value);
+
+        return value;
+    }
+
+    /// @brief Reads a count, which also has to be small enough to fit in the remaining data
+    int32_t readCount(size_t bytesPerElement)
+    {
+        int32_t count = readInt();
+
+        if (count < 0 || (uint64_t)count * bytesPerElement > data.size() - position)
+        {
+            throw GameState::InvalidCheckpoint();
+        }
+
+        return count;
+    }
+
+    string_view readBytes(size_t length)
+    {
+        if (position + length > data.size())
+        {
+            throw GameState::InvalidCheckpoint();
+        }
+
+        string_view bytes = data.substr(position, length);
+        position += length;
+
+        return bytes;
+    }
+
+    bool atEnd() const
+    {
+        return position == data.size();
+    }
+};
+
+/// @brief Number of 32 bit values in a RobotState record
+const int ROBOT_STATE_VALUES = 11;
+
+inline void writeInt(ostream &output, int32_t value)
+{
+    output.write((const char *)&value, sizeof(value));
+}
+
+inline void writeRobotStates(ostream &output, const vector<RobotState> &robots)
+{
+    writeInt(output, (int32_t)robots.size());
+
+    for (const RobotState &robot : robots)
+    {
+        int32_t values[ROBOT_STATE_VALUES] = {
+            robot.type, robot.id, robot.nameIndex, robot.posX, robot.posY, robot.lives,
+            robot.killsToNextEvolve, robot.readyToEvolve, robot.nextTurn,
+            robot.firePositionX, robot.firePositionY};
+
+        output.write((const char *)values, sizeof(values));
+    }
+}
+
+inline vector<RobotState> readRobotStates(CheckpointReader &reader)
+{
+    int32_t count = reader.readCount(ROBOT_STATE_VALUES * sizeof(int32_t));
+
+    vector<RobotState> robots(count);
+
+    for (RobotState &robot : robots)
+    {
+        robot.type = (RobotType)reader.readInt();
+        robot.id = reader.readInt();
+        robot.nameIndex = reader.readInt();
+        robot.posX = reader.readInt();
+        robot.posY = reader.readInt();
+        robot.lives = reader.readInt();
+        robot.killsToNextEvolve = reader.readInt();
+        robot.readyToEvolve = reader.readInt() != 0;
+        robot.nextTurn = reader.readInt();
+        robot.firePositionX = reader.readInt();
+        robot.firePositionY = reader.readInt();
+
+        if (robot.type < 0 || robot.type >= INVALID_ROBOT_TYPE)
+        {
+            throw GameState::InvalidCheckpoint();
+        }
+    }
+
+    return robots;
+}
+
+inline void GameState::write(ostream &output) const
+{
+    output.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    writeInt(output, CHECKPOINT_VERSION);
+
+    writeInt(output, turn);
+    writeInt(output, turnLimit);
+    writeInt(output, width);
+    writeInt(output, height);
+    writeInt(output, nextRobotId);
+
+    const vector<string> noNames;
+    const vector<string> &nameTable = names == nullptr ? noNames : *names;
+
+    writeInt(output, (int32_t)nameTable.size());
+    for (const string &name : nameTable)
+    {
+        writeInt(output, (int32_t)name.size());
+        output.write(name.data(), name.size());
+    }
+
+    writeRobotStates(output, robots);
+    writeRobotStates(output, revivingRobots);
+
+    const vector<uint32_t> &savedRandomState = randomState.empty() ? RNG::seededState(randomSeed) : randomState;
+
+    writeInt(output, (int32_t)savedRandomState.size());
+    output.write((const char *)savedRandomState.data(), savedRandomState.size() * sizeof(uint32_t));
+}
+
+inline GameState GameState::read(string_view data)
+{
+    if (!isCheckpoint(data))
+    {
+        throw InvalidCheckpoint();
+    }
+
+    CheckpointReader reader(data.substr(sizeof(CHECKPOINT_MAGIC)));
+
+    if (reader.readInt() != CHECKPOINT_VERSION)
+    {
+        throw InvalidCheckpoint();
+    }
+
+    GameState state;
+    state.turn = reader.readInt();
+    state.turnLimit = reader.readInt();
+    state.width = reader.readInt();
+    state.height = reader.readInt();
+    state.nextRobotId = reader.readInt();
+
+    if (state.width <= 0 || state.height <= 0 || state.nextRobotId < 0)
+    {
+        throw InvalidCheckpoint();
+    }
+
+    int32_t nameCount = reader.readCount(sizeof(int32_t));
+    vector<string> names;
+    names.reserve(nameCount);
+
+    for (int i = 0; i < nameCount; i++)
+    {
+        int32_t length = reader.readCount(1);
+        names.push_back(string(reader.readBytes(length)));
+    }
+
+    state.names = make_shared<const vector<string>>(move(names));
+
+    state.robots = readRobotStates(reader);
+    state.revivingRobots = readRobotStates(reader);
+
+    int32_t wordCount = reader.readCount(sizeof(uint32_t));
+    state.randomState.resize(wordCount);
+
+    for (uint32_t &word : state.randomState)
+    {
+        word = (uint32_t)reader.readInt();
+    }
+
+    // a damaged state would otherwise leave the generator partly overwritten
+    if (!RNG::isValidState(state.randomState))
+    {
+        throw InvalidCheckpoint();
+    }
+
+    if (!reader.atEnd())
+    {
+        throw InvalidCheckpoint();
+    }
+
+    return state;
+}
+
+inline bool GameState::isCheckpoint(string_view contents)
+{
+    return contents.size() >= sizeof(CHECKPOINT_MAGIC) && memcmp(contents.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0;
+}
+
+#endif
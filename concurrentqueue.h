@@ -0,0 +1,224 @@
+/*
+ *
+ * This file contains the ConcurrentQueue class, a bounded queue that many
+ * threads can push to and pop from at the same time without locks
+ *
+ * --- Code Summary ---
+ * Like Deque (see deque.h), the queue is a ring buffer whose capacity is a
+ * power of two. Every slot of the ring also holds a sequence number that
+ * tells the threads whose turn it is to use the slot:
+ *
+ *   sequence == position          the slot is free for the push at position
+ *   sequence == position + 1      the slot holds the element pushed at position,
+ *                                 ready for the pop at position
+ *
+ * where position counts every push (or pop) ever made. A pushing thread reads
+ * the next push position, checks the sequence of its slot and claims the
+ * position with a compare-and-swap; only then does it write the element and
+ * publish it by advancing the sequence. Popping works the same way from the
+ * other end, and frees the slot for the push one lap of the ring later. No
+ * thread ever waits for a lock, and threads only contend on the same atomic
+ * when they push (or pop) at the same moment.
+ *
+ * The queue never grows: push_back() fails when the queue is full and
+ * pop_front() fails when it is empty, and the caller decides whether to retry,
+ * wait or give up.
+ *
+ * BatchRunner (see batch.h) does not use it. Its workers steal the newest game
+ * of another worker's queue, which a FIFO queue cannot do, a batch can hold
+ * any number of games and results, and workers and callers still have to
+ * sleep on a condition variable when there is nothing to do. A game also takes
+ * far longer than a locked hand-off. The queue is measured by the benchmark,
+ * for code that hands off many small jobs.
+ *
+ */
+
+#ifndef CONCURRENTQUEUE_H
+#define CONCURRENTQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+using namespace std;
+
+// Generic lock-free bounded multi-producer multi-consumer queue class
+template <typename T>
+class ConcurrentQueue
+{
+private:
+    struct Slot
+    {
+        atomic<size_t> sequence;
+        T data;
+    };
+
+    unique_ptr<Slot[]> buffer;
+    size_t capacity = 0;
+
+    /// @brief the head & tail are kept on separate cache lines, so that pushing
+    /// threads and popping threads do not slow each other down
+    static const int CACHE_LINE_SIZE = 64;
+
+    /// @brief position of the next pop
+    alignas(CACHE_LINE_SIZE) atomic<size_t> head;
+
+    /// @brief position of the next push
+    alignas(CACHE_LINE_SIZE) atomic<size_t> tail;
+
+public:
+    // Exception for a capacity that is not positive
+    class InvalidCapacity
+    {
+    };
+
+    /// @param capacity most elements the queue holds at once, rounded up to a power of two
+    /// @exception InvalidCapacity thrown if capacity is less than 1
+    ConcurrentQueue(int capacity);
+
+    ConcurrentQueue(const ConcurrentQueue &) = delete;
+    ConcurrentQueue &operator=(const ConcurrentQueue &) = delete;
+
+    /*---------------------------------------------*/
+    /*                 Accessors                   */
+    /*---------------------------------------------*/
+
+    /// @return the number of elements in the queue. While other threads push or
+    /// pop, it may already be out of date when it returns
+    int size() const;
+    bool is_empty() const;
+    int getCapacity() const;
+
+    /*---------------------------------------------*/
+    /*                 Modifiers                   */
+    /*---------------------------------------------*/
+
+    /// @brief Adds an element at the back of the queue
+    /// @return false if the queue was full, in which case nothing is added
+    bool push_back(T data);
+
+    /// @brief Removes the element at the front of the queue
+    /// @param data the removed element
+    /// @return false if the queue was empty, in which case data is unchanged
+    bool pop_front(T &data);
+};
+
+template <typename T>
+inline ConcurrentQueue<T>::ConcurrentQueue(int capacity)
+{
+    if (capacity < 1)
+    {
+        throw InvalidCapacity();
+    }
+
+    // at least 2 slots: with one, a slot holding the element pushed at position has the
+    // sequence that frees it for the push at position + 1
+    size_t roundedCapacity = 2;
+    while (roundedCapacity < (size_t)capacity)
+    {
+        roundedCapacity *= 2;
+    }
+
+    this->capacity = roundedCapacity;
+    buffer = make_unique<Slot[]>(roundedCapacity);
+
+    for (size_t i = 0; i < roundedCapacity; i++)
+    {
+        buffer[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    head.store(0, memory_order_relaxed);
+    tail.store(0, memory_order_relaxed);
+}
+
+template <typename T>
+inline int ConcurrentQueue<T>::size() const
+{
+    size_t tailPosition = tail.load(memory_order_acquire);
+    size_t headPosition = head.load(memory_order_acquire);
+
+    // a pop that finished after tail was read can leave head ahead of it
+    return tailPosition > headPosition ? (int)(tailPosition - headPosition) : 0;
+}
+
+template <typename T>
+inline bool ConcurrentQueue<T>::is_empty() const
+{
+    return size() == 0;
+}
+
+template <typename T>
+inline int ConcurrentQueue<T>::getCapacity() const
+{
+    return capacity;
+}
+
+template <typename T>
+inline bool ConcurrentQueue<T>::push_back(T data)
+{
+    size_t position = tail.load(memory_order_relaxed);
+
+    while (true)
+    {
+        Slot &slot = buffer[position & (capacity - 1)];
+        size_t sequence = slot.sequence.load(memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)position;
+
+        if (difference == 0)
+        {
+            // the slot is free: claim the position, or retry from wherever another push moved the tail
+            if (tail.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+            {
+                slot.data = move(data);
+                slot.sequence.store(position + 1, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // the slot still holds the element pushed one lap earlier
+            return false;
+        }
+        else
+        {
+            // another push has already claimed this position
+            position = tail.load(memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+inline bool ConcurrentQueue<T>::pop_front(T &data)
+{
+    size_t position = head.load(memory_order_relaxed);
+
+    while (true)
+    {
+        Slot &slot = buffer[position & (capacity - 1)];
+        size_t sequence = slot.sequence.load(memory_order_acquire);
+        ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)(position + 1);
+
+        if (difference == 0)
+        {
+            if (head.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+            {
+                data = move(slot.data);
+
+                // free the slot for the push one lap later
+                slot.sequence.store(position + capacity, memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // nothing has been pushed at this position yet
+            return false;
+        }
+        else
+        {
+            position = head.load(memory_order_relaxed);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ *
+ * This file contains the classes that load the game's initial config file
+ *
+ * --- Code Summary ---
+ * MappedFile maps a whole file into memory so that it can be read as one
+ * string_view without copying it into a buffer first.
+ *
+ * ConfigParser walks over the config text one character at a time. Numbers are
+ * converted with from_chars and names are returned as string_views pointing
+ * into the text, so nothing is copied or allocated while parsing. The robots
+ * are read one at a time with nextRobot() so a config with a million robots
+ * never has to be held in memory twice.
+ *
+ * Whenever the text does not follow the config format, a ConfigError is
+ * thrown containing the line & column where the problem was found.
+ *
+ * --- Config Format ---
+ * M by N : <width> <height>
+ * turns: <turn limit>
+ * robots: <number of robots>
+ * <robot type> <robot name> <X position or random> <Y position or random>
+ * ...
+ *
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <charconv>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "robot.h"
+
+using namespace std;
+
+class MappedFile
+{
+private:
+    const char *data = nullptr;
+    size_t length = 0;
+
+public:
+    // Exception for when the file could not be opened or mapped
+    class OpeningError
+    {
+    };
+
+    /// @brief Maps the whole file into memory as read only
+    /// @param filename path of the file
+    /// @exception OpeningError thrown if the file could not be opened or mapped
+    MappedFile(const string &filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /// @return the contents of the file
+    string_view getText() const;
+};
+
+inline MappedFile::MappedFile(const string &filename)
+{
+    int fileDescriptor = open(filename.c_str(), O_RDONLY);
+
+    if (fileDescriptor < 0)
+    {
+        throw OpeningError();
+    }
+
+    struct stat fileInfo;
+    if (fstat(fileDescriptor, &fileInfo) != 0)
+    {
+        close(fileDescriptor);
+        throw OpeningError();
+    }
+
+    length = fileInfo.st_size;
+
+    // mmap cannot map an empty file, an empty file is left as an empty string_view
+    if (length > 0)
+    {
+        void *mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+        if (mapping == MAP_FAILED)
+        {
+            close(fileDescriptor);
+            throw OpeningError();
+        }
+
+        // the file is read from front to back exactly once
+        madvise(mapping, length, MADV_SEQUENTIAL);
+        data = (const char *)mapping;
+    }
+
+    // the mapping stays valid after the file descriptor is closed
+    close(fileDescriptor);
+}
+
+inline MappedFile::~MappedFile()
+{
+    if (data != nullptr)
+    {
+        munmap((void *)data, length);
+    }
+}
+
+inline string_view MappedFile::getText() const
+{
+    return string_view(data, length);
+}
+
+class ConfigParser
+{
+public:
+    /// @brief Position value used for robots that are placed at a random position
+    static const int RANDOM_POSITION = -1;
+
+    /// @brief One robot entry of the config file. typeName & name point into the config text
+    struct RobotEntry
+    {
+        RobotType type = INVALID_ROBOT_TYPE;
+        string_view typeName;
+        string_view name;
+        int posX = RANDOM_POSITION;
+        int posY = RANDOM_POSITION;
+    };
+
+    // Exception for config text that does not follow the config format
+    class ConfigError
+    {
+    public:
+        int line;
+        int column;
+        string message;
+
+        ConfigError(int line, int column, string message)
+        {
+            this->line = line;
+            this->column = column;
+            this->message = message;
+        }
+    };
+
+    ConfigParser(string_view text);
+
+    /*---------------------------------------------*/
+    /*                 Accessors                   */
+    /*---------------------------------------------*/
+
+    int getWidth() const;
+    int getHeight() const;
+    int getTurnLimit() const;
+    int getRobotCount() const;
+
+    /*---------------------------------------------*/
+    /*                  Parsing                    */
+    /*---------------------------------------------*/
+
+    /// @brief Reads the board size, turn limit & number of robots
+    /// @exception ConfigError thrown if the header lines are invalid
+    void parseHeader();
+
+    /// @brief Reads the next robot entry
+    /// @param entry the robot entry that is read in
+    /// @return true if a robot was read, false once every robot has been read
+    /// @exception ConfigError thrown if the robot entry is invalid
+    bool nextRobot(RobotEntry &entry);
+
+private:
+    string_view text;
+
+    /// @brief index of the next character to read
+    size_t position = 0;
+
+    /// @brief index of the first character of the current line
+    size_t lineStart = 0;
+    int line = 1;
+
+    int width = 0;
+    int height = 0;
+    int turnLimit = 0;
+    int robotCount = 0;
+    int robotsRead = 0;
+
+    [[noreturn]] void error(size_t at, const string &message) const;
+
+    bool atLineEnd() const;
+    void skipSpaces();
+    void expect(string_view literal);
+    string_view readWord();
+    int readInteger(const char *description, int min, int max);
+    int readPosition(const char *description, int boardSize);
+    void endLine();
+    void skipBlankLines();
+};
+
+inline ConfigParser::ConfigParser(string_view text)
+{
+    this->text = text;
+}
+
+inline int ConfigParser::getWidth() const
+{
+    return width;
+}
+
+inline int ConfigParser::getHeight() const
+{
+    return height;
+}
+
+inline int ConfigParser::getTurnLimit() const
+{
+    return turnLimit;
+}
+
+inline int ConfigParser::getRobotCount() const
+{
+    return robotCount;
+}
+
+/// @brief Throws a ConfigError pointing at a character of the current line
+/// @param at index of the character the error refers to
+/// @param message description of the error
+inline void ConfigParser::error(size_t at, const string &message) const
+{
+    throw ConfigError(line, (int)(at - lineStart) + 1, message);
+}
+
+/// @return true if the next character ends the current line
+inline bool ConfigParser::atLineEnd() const
+{
+    return position >= text.size() || text[position] == '\n' || text[position] == '\r';
+}
+
+/// @brief Skips spaces & tabs
+inline void ConfigParser::skipSpaces()
+{
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t'))
+    {
+        position++;
+    }
+}
+
+/// @brief Reads the given text, ignoring any spaces in front of it
+/// @param literal text that is expected next
+inline void ConfigParser::expect(string_view literal)
+{
+    skipSpaces();
+
+    if (text.compare(position, literal.size(), literal) != 0)
+    {
+        error(position, "expected \"" + string(literal) + "\"");
+    }
+
+    position += literal.size();
+}
+
+/// @brief Reads the next word, ignoring any spaces in front of it
+/// @return the word, empty if the line has ended
+inline string_view ConfigParser::readWord()
+{
+    skipSpaces();
+
+    size_t start = position;
+    while (!atLineEnd() && text[position] != ' ' && text[position] != '\t')
+    {
+        position++;
+    }
+
+    return text.substr(start, position - start);
+}
+
+/// @brief Reads an integer in the range [min, max]
+/// @param description what the integer represents, used in error messages
+/// @return the integer
+inline int ConfigParser::readInteger(const char *description, int min, int max)
+{
+    skipSpaces();
+
+    size_t start = position;
+    string_view word = readWord();
+    int value = 0;
+
+    auto result = from_chars(word.data(), word.data() + word.size(), value);
+
+    if (word.empty() || result.ec != errc() || result.ptr != word.data() + word.size())
+    {
+        error(start, string("expected ") + description + " but found \"" + string(word) + "\"");
+    }
+
+    if (value < min || value > max)
+    {
+        error(start, string(description) + " must be between " + to_string(min) + " and " + to_string(max));
+    }
+
+    return value;
+}
+
+/// @brief Reads a robot position, which is either "random" or an integer inside the board
+/// @param description what the position represents, used in error messages
+/// @param boardSize board width or height
+/// @return the position, RANDOM_POSITION if the position is "random"
+inline int ConfigParser::readPosition(const char *description, int boardSize)
+{
+    skipSpaces();
+
+    if (text.compare(position, 6, "random") == 0)
+    {
+        size_t start = position;
+        if (readWord() == "random")
+        {
+            return RANDOM_POSITION;
+        }
+        position = start;
+    }
+
+    return readInteger(description, 0, boardSize - 1);
+}
+
+/// @brief Moves to the start of the next line, only allowing spaces before the line ends
+inline void ConfigParser::endLine()
+{
+    skipSpaces();
+
+    if (!atLineEnd())
+    {
+        error(position, "unexpected \"" + string(readWord()) + "\" at the end of the line");
+    }
+
+    if (position < text.size() && text[position] == '\r')
+    {
+        position++;
+    }
+
+    if (position < text.size() && text[position] == '\n')
+    {
+        position++;
+    }
+
+    line++;
+    lineStart = position;
+}
+
+/// @brief Skips lines that only contain spaces
+inline void ConfigParser::skipBlankLines()
+{
+    while (position < text.size())
+    {
+        size_t start = position;
+        skipSpaces();
+
+        if (position >= text.size() || !atLineEnd())
+        {
+            position = start;
+            return;
+        }
+
+        endLine();
+    }
+}
+
+inline void ConfigParser::parseHeader()
+{
+    expect("M by N");
+    expect(":");
+    width = readInteger("board width", 1, 1 << 30);
+    height = readInteger("board height", 1, 1 << 30);
+    endLine();
+
+    expect("turns:");
+    turnLimit = readInteger("turn limit", 0, 1 << 30);
+    endLine();
+
+    expect("robots:");
+    robotCount = readInteger("number of robots", 0, 1 << 30);
+    endLine();
+}
+
+inline bool ConfigParser::nextRobot(RobotEntry &entry)
+{
+    if (robotsRead == robotCount)
+    {
+        skipBlankLines();
+
+        if (position < text.size())
+        {
+            error(position, "more robots than the " + to_string(robotCount) + " given in \"robots:\"");
+        }
+
+        return false;
+    }
+
+    skipBlankLines();
+
+    if (position >= text.size())
+    {
+        error(position, "expected " + to_string(robotCount) + " robots but only found " + to_string(robotsRead));
+    }
+
+    size_t typeStart = position;
+    entry.typeName = readWord();
+    entry.type = robotTypeFromName(entry.typeName);
+
+    if (entry.type == INVALID_ROBOT_TYPE)
+    {
+        error(typeStart, "the robot type \"" + string(entry.typeName) + "\" could not be interpreted");
+    }
+
+    skipSpaces();
+    size_t nameStart = position;
+    entry.name = readWord();
+
+    if (entry.name.empty())
+    {
+        error(nameStart, "expected a robot name");
+    }
+
+    entry.posX = readPosition("X position", width);
+    entry.posY = readPosition("Y position", height);
+    endLine();
+
+    robotsRead++;
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ *
+ * This file contains the command line tool that converts a text config file
+ * into a binary scenario file (see scenario.h)
+ *
+ * --- Usage ---
+ * convert.out <text config file> <binary scenario file>
+ *
+ * The binary scenario file can be given to the game in place of the text
+ * config file.
+ *
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "scenario.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        cerr << "Usage: " << argv[0] << " <text config file> <binary scenario file>" << endl;
+        return 1;
+    }
+
+    string configFilename = argv[1];
+    string scenarioFilename = argv[2];
+
+    try
+    {
+        MappedFile configFile(configFilename);
+        ofstream scenarioFile(scenarioFilename, ofstream::binary);
+
+        if (!scenarioFile.is_open())
+        {
+            cerr << "[ERROR] Error opening binary scenario file " << scenarioFilename << endl;
+            return 1;
+        }
+
+        ScenarioWriter::convert(configFile.getText(), scenarioFile);
+    }
+    catch (MappedFile::OpeningError)
+    {
+        cerr << "[ERROR] Error opening text config file " << configFilename << endl;
+        return 1;
+    }
+    catch (const ConfigParser::ConfigError &error)
+    {
+        cerr << "[ERROR] " << configFilename << ":" << error.line << ":" << error.column << ": " << error.message << endl;
+        return 1;
+    }
+    catch (ScenarioWriter::NameTooLong)
+    {
+        cerr << "[ERROR] A robot name in " << configFilename << " is too long" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -4,9 +4,12 @@
  * as a container for queue-like behavior
  *
  * --- Code Summary ---
- * The deque is implemented using a node-linking structure with node containing
- * pointers to the previous node & pointers to the next node. The deque also
- * has the added ability to reference contained elements using the [] operator.
+ * The deque is implemented as a ring buffer: the elements are stored in one
+ * array that wraps around, with the index of the front element and the number
+ * of elements kept alongside it. Pushing and popping at either end, size() and
+ * referencing elements with the [] operator all take constant time. When the
+ * array is full, it is replaced by one twice as large. reserve() can be used to
+ * allocate the array up front when the number of elements is known in advance.
  *
  * --- Reasoning for creating deque instead of queue ---
  * I had initially chose to implement a deque instead of a normal queue class
@@ -19,26 +22,36 @@
 #ifndef DEQUE_H
 #define DEQUE_H
 
+#include <utility>
+
 // Generic double-ended queue class
 template <typename T>
 class Deque
 {
 private:
-    // Node linking Structure
+    // Ring Buffer Structure
     //
-    //              Head                          Tail
-    // nullptr  <- [node] ->   <- [node] ->   <- [node] ->  nullptr
-    //         prev data next prev data next prev data next
+    //  index:   0      1      2      3      4      5      6      7
+    //        [data] [    ] [    ] [    ] [data] [data] [data] [data]
+    //          back                       front
     //
-    struct node
-    {
-        T data;
-        node *prev = nullptr;
-        node *next = nullptr;
-    };
+    // The capacity is always a power of two so that wrapping an index
+    // around the end of the array is a single bitwise AND.
+    //
+    T *buffer = nullptr;
+    int capacity = 0;
+
+    /// @brief index in buffer of the element at the front of the deque
+    int head = 0;
+
+    /// @brief number of elements in the deque
+    int count = 0;
+
+    /// @brief Converts a position in the deque to an index in buffer
+    int slot(int i) const;
 
-    node *head = nullptr;
-    node *tail = nullptr;
+    /// @brief Moves all elements into a new array of newCapacity elements
+    void reallocate(int newCapacity);
 
     // Out of bounds Exception Class
     class OutOfBounds
@@ -55,11 +68,12 @@ public:
     /*                 Accessors                   */
     /*---------------------------------------------*/
 
-    int size();
-    bool is_empty();
+    int size() const;
+    bool is_empty() const;
     T &front();
     T &back();
     T &operator[](int i);
+    const T &operator[](int i) const;
 
     /*---------------------------------------------*/
     /*                 Modifiers                   */
@@ -70,8 +84,9 @@ public:
     T pop_back();
     T pop_front();
     void clear();
-    T &operator=(T &rval);
-    T &operator=(T &&rval);
+    void reserve(int newCapacity);
+    Deque &operator=(const Deque &rval);
+    Deque &operator=(Deque &&rval);
 
     void erase(int i);
 };
@@ -84,12 +99,8 @@ inline Deque<T>::Deque()
 template <typename T>
 inline Deque<T>::~Deque()
 {
-    clear();
-
-    delete head;
-    delete tail;
-    head = nullptr;
-    tail = nullptr;
+    delete[] buffer;
+    buffer = nullptr;
 }
 
 /// @brief Copy constructor
@@ -97,10 +108,7 @@ inline Deque<T>::~Deque()
 template <typename T>
 inline Deque<T>::Deque(const Deque &object)
 {
-    if (object.size() == 0)
-    {
-        return;
-    }
+    reserve(object.size());
 
     for (int i = 0; i < object.size(); i++)
     {
@@ -113,43 +121,48 @@ inline Deque<T>::Deque(const Deque &object)
 template <typename T>
 inline Deque<T>::Deque(Deque &&object)
 {
-    head = object.head;
-    tail = object.tail;
+    std::swap(buffer, object.buffer);
+    std::swap(capacity, object.capacity);
+    std::swap(head, object.head);
+    std::swap(count, object.count);
+}
 
-    object.head = nullptr;
-    object.tail = nullptr;
+template <typename T>
+inline int Deque<T>::slot(int i) const
+{
+    return (head + i) & (capacity - 1);
 }
 
-/// @brief Returns the number of elements in the deque
-/// @return int detailing how many elements are in the deque
 template <typename T>
-inline int Deque<T>::size()
+inline void Deque<T>::reallocate(int newCapacity)
 {
-    node *cursor = head;
-    int counter = 0;
+    T *newBuffer = new T[newCapacity];
 
-    while (cursor != nullptr)
+    for (int i = 0; i < count; i++)
     {
-        counter += 1;
-        cursor = cursor->next;
+        newBuffer[i] = std::move(buffer[slot(i)]);
     }
 
-    return counter;
+    delete[] buffer;
+    buffer = newBuffer;
+    capacity = newCapacity;
+    head = 0;
+}
+
+/// @brief Returns the number of elements in the deque
+/// @return int detailing how many elements are in the deque
+template <typename T>
+inline int Deque<T>::size() const
+{
+    return count;
 }
 
 /// @brief checks whether the deque is empty
 /// @return true if the deque is empty, false otherwise
 template <typename T>
-inline bool Deque<T>::is_empty()
+inline bool Deque<T>::is_empty() const
 {
-    if (head == nullptr)
-    {
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    return count == 0;
 }
 
 /// @brief references the element at the front of the deque
@@ -162,8 +175,8 @@ inline T &Deque<T>::front()
     {
         throw OutOfBounds();
     }
-    
-    return head->data;
+
+    return buffer[head];
 }
 
 /// @brief references the element at the back of the deque
@@ -177,7 +190,7 @@ inline T &Deque<T>::back()
         throw OutOfBounds();
     }
 
-    return tail->data;
+    return buffer[slot(count - 1)];
 }
 
 /// @brief
@@ -188,19 +201,28 @@ inline T &Deque<T>::back()
 template <typename T>
 inline T &Deque<T>::operator[](int i)
 {
-    if (i >= this->size() || i < 0)
+    if (i >= count || i < 0)
     {
         throw OutOfBounds();
     }
 
-    node *cursor = this->head;
-    
-    for (; i > 0; i--)
+    return buffer[slot(i)];
+}
+
+/// @brief
+/// @tparam T datatype
+/// @param i index
+/// @return const reference to object at index i
+/// @exception OutOfBounds thrown when referencing an invalid index
+template <typename T>
+inline const T &Deque<T>::operator[](int i) const
+{
+    if (i >= count || i < 0)
     {
-        cursor = cursor->next;
+        throw OutOfBounds();
     }
 
-    return cursor->data;
+    return buffer[slot(i)];
 }
 
 /// @brief Add element at the end of the deque
@@ -208,23 +230,13 @@ inline T &Deque<T>::operator[](int i)
 template <typename T>
 inline void Deque<T>::push_back(T data)
 {
-    // Create new node
-    node *new_node = new node;
-    new_node->data = data;
-
-    // if the list is empty
-    if (tail == nullptr)
+    if (count == capacity)
     {
-        tail = new_node;
-        head = new_node;
-
-        return;
+        reallocate(capacity == 0 ? 8 : capacity * 2);
     }
 
-    tail->next = new_node;
-    new_node->prev = tail;
-
-    tail = new_node;
+    buffer[slot(count)] = std::move(data);
+    count++;
 }
 
 /// @brief Pushes a new element to the front of the deque
@@ -232,23 +244,14 @@ inline void Deque<T>::push_back(T data)
 template <typename T>
 inline void Deque<T>::push_front(T data)
 {
-    // Create new node
-    node *new_node = new node;
-    new_node->data = data;
-    
-    // If the list is empty
-    if (is_empty())
+    if (count == capacity)
     {
-        head = new_node;
-        tail = new_node;
-
-        return;
+        reallocate(capacity == 0 ? 8 : capacity * 2);
     }
 
-    head->prev = new_node;
-    new_node->next = head;
-
-    head = new_node;
+    head = (head - 1) & (capacity - 1);
+    buffer[head] = std::move(data);
+    count++;
 }
 
 /// @brief Pops out the object at the back of the deque
@@ -257,38 +260,14 @@ inline void Deque<T>::push_front(T data)
 template <typename T>
 inline T Deque<T>::pop_back()
 {
-    if (tail == nullptr)
+    if (is_empty())
     {
         throw OutOfBounds();
     }
 
-    node *temp = tail;
-    T returnData = temp->data;
+    count--;
 
-    if (tail == head)
-    {
-        tail = nullptr;
-        head = nullptr;
-    }
-    else
-    {
-        tail = tail->prev;
-        tail->next = nullptr;
-    }
-
-    temp->next = nullptr;
-    temp->prev = nullptr;
-
-    delete temp->next;
-    delete temp->prev;
-
-    temp->prev = nullptr;
-    temp->next = nullptr;
-
-    delete temp;
-    temp = nullptr;
-
-    return returnData;
+    return std::move(buffer[slot(count)]);
 }
 
 /// @brief Pops out the object at the front of the deque
@@ -302,31 +281,10 @@ inline T Deque<T>::pop_front()
         throw OutOfBounds();
     }
 
-    node *temp = head;
-    T returnData = temp->data;
-
-    if (tail == head)
-    {
-        tail = nullptr;
-        head = nullptr;
-    }
-    else
-    {
-        head = head->next;
-        head->prev = nullptr;
-    }
-
-    temp->next = nullptr;
-    temp->prev = nullptr;
+    T returnData = std::move(buffer[head]);
 
-    delete temp->next;
-    delete temp->prev;
-    
-    temp->prev = nullptr;
-    temp->next = nullptr;
-
-    delete temp;
-    temp = nullptr;
+    head = (head + 1) & (capacity - 1);
+    count--;
 
     return returnData;
 }
@@ -339,21 +297,44 @@ inline void Deque<T>::clear()
     {
         pop_back();
     }
+
+    head = 0;
+}
+
+/// @brief Allocates space for at least newCapacity elements so that the deque
+/// does not need to grow until it holds more than newCapacity elements
+/// @param newCapacity number of elements to allocate space for
+template <typename T>
+inline void Deque<T>::reserve(int newCapacity)
+{
+    if (newCapacity <= capacity)
+    {
+        return;
+    }
+
+    int roundedCapacity = 8;
+    while (roundedCapacity < newCapacity)
+    {
+        roundedCapacity *= 2;
+    }
+
+    reallocate(roundedCapacity);
 }
 
 /// @brief Copy assignment operator
 /// @param rval
 /// @return
 template <typename T>
-inline T &Deque<T>::operator=(T &rval)
+inline Deque<T> &Deque<T>::operator=(const Deque &rval)
 {
     if (this != &rval)
     {
-        node *cursor = rval.head;
-        while (cursor != nullptr)
+        clear();
+        reserve(rval.size());
+
+        for (int i = 0; i < rval.size(); i++)
         {
-            push_back(cursor->data);
-            cursor = cursor->next;
+            push_back(rval[i]);
         }
     }
 
@@ -364,72 +345,54 @@ inline T &Deque<T>::operator=(T &rval)
 /// @param rval
 /// @return
 template <typename T>
-inline T &Deque<T>::operator=(T &&rval)
+inline Deque<T> &Deque<T>::operator=(Deque &&rval)
 {
     if (this != &rval)
     {
-        swap(head, rval.head);
-        swap(tail, rval.tail);
+        std::swap(buffer, rval.buffer);
+        std::swap(capacity, rval.capacity);
+        std::swap(head, rval.head);
+        std::swap(count, rval.count);
 
-        rval.head = nullptr;
-        rval.tail = nullptr;
+        rval.clear();
     }
 
     return *this;
 }
 
 /// @brief Erases an element
+/// @details The elements between the erased element and the nearest end of
+///          the deque are shifted over by one to close the gap.
 /// @param i index of element to erase
 /// @exception OutOfBounds thrown when referencing an invalid index
 template <typename T>
 inline void Deque<T>::erase(int i)
 {
-    if (i >= size() || i < 0) {
-        throw OutOfBounds();
-    }
-
-    if (is_empty())
+    if (i >= count || i < 0)
     {
         throw OutOfBounds();
     }
 
-    node *currentNode = head;
-    for (; i > 0; i--)
-    {
-        currentNode = currentNode->next;
-    }
-
-    node *nextNode = currentNode->next;
-    node *prevNode = currentNode->prev;
-
-    if (prevNode != nullptr)
-    {
-        prevNode->next = nextNode;
-    }
-
-    if (nextNode != nullptr)
+    if (i < count / 2)
     {
-        nextNode->prev = prevNode;
-    }
+        // shift the elements in front of the erased element back by one
+        for (int j = i; j > 0; j--)
+        {
+            buffer[slot(j)] = std::move(buffer[slot(j - 1)]);
+        }
 
-    if (currentNode == tail) {
-        tail = prevNode;
+        head = (head + 1) & (capacity - 1);
     }
-
-    if (currentNode == head)
+    else
     {
-        head = nextNode;
+        // shift the elements behind the erased element forward by one
+        for (int j = i; j < count - 1; j++)
+        {
+            buffer[slot(j)] = std::move(buffer[slot(j + 1)]);
+        }
     }
 
-    nextNode = nullptr;
-    prevNode = nullptr;
-    delete nextNode;
-    delete prevNode;
-    nextNode = nullptr;
-    prevNode = nullptr;
-
-    delete currentNode;
-    currentNode = nullptr;
+    count--;
 }
 
 #endif
@@ -0,0 +1,92 @@
+/*
+ *
+ * This file contains the command line tool that generates game config files
+ * using the ScenarioGenerator class
+ *
+ * --- Usage ---
+ * generate.out [options]
+ *
+ *   --width W            board width (default 50)
+ *   --height H           board height (default 50)
+ *   --turns T            turn limit (default 300)
+ *   --robots N           number of robots (default 10)
+ *   --mix TYPE=R,...     robot types & ratios, e.g. RoboCop=3,Terminator=1
+ *   --clustered K        gather the robots around K clusters instead of
+ *                        spreading them uniformly over the board
+ *   --spread S           standard deviation of the cluster size
+ *   --seed S             seed of the generator (default 0)
+ *   --output FILE        file to write the config to (default: the terminal)
+ *
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "generator.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    ScenarioGenerator generator;
+    string outputFilename;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            cerr << "[ERROR] Missing value for option " << option << endl;
+            return 1;
+        }
+
+        string value = argv[++i];
+
+        try
+        {
+            if (option == "--seed")
+                generator.seed = stoul(value);
+            else if (option == "--output")
+                outputFilename = value;
+            else if (!generator.setOption(option, value))
+            {
+                cerr << "[ERROR] Unknown option " << option << endl;
+                return 1;
+            }
+        }
+        catch (const logic_error &)
+        {
+            cerr << "[ERROR] Invalid value " << value << " for option " << option << endl;
+            return 1;
+        }
+    }
+
+    try
+    {
+        if (outputFilename.empty())
+        {
+            generator.write(cout);
+        }
+        else
+        {
+            ofstream outputFile(outputFilename);
+
+            if (!outputFile.is_open())
+            {
+                cerr << "[ERROR] Error opening output file " << outputFilename << endl;
+                return 1;
+            }
+
+            generator.write(outputFile);
+        }
+    }
+    catch (ScenarioGenerator::InvalidParameters)
+    {
+        cerr << "[ERROR] The given parameters cannot produce a valid config" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ *
+ * This file contains the ScenarioGenerator class that generates game config
+ * files from a small set of parameters
+ *
+ * --- Code Summary ---
+ * The generator first works out exactly how many robots of every type should
+ * be created from the type mix ratios, shuffles that list of types and then
+ * places every robot on a unique board position, either spread uniformly over
+ * the whole board or gathered around a number of randomly placed clusters.
+ *
+ * The output follows the exact format read by Game (M by N / turns: / robots:),
+ * so it can be written to a file or given to Game directly as an
+ * InMemoryConfig without touching the disk. The same parameters and seed always
+ * produce the same config.
+ *
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class ScenarioGenerator
+{
+public:
+    enum Placement
+    {
+        UNIFORM,
+        CLUSTERED
+    };
+
+    // Exception for parameters that cannot produce a valid config
+    // (empty board, more robots than cells, unknown robot type, etc.)
+    class InvalidParameters
+    {
+    };
+
+    /*---------------------------------------------*/
+    /*                 Parameters                  */
+    /*---------------------------------------------*/
+
+    int width = 50;
+    int height = 50;
+    int turns = 300;
+    int robotCount = 10;
+
+    /// @brief Robot types to create and the ratio of robots each of them gets
+    vector<pair<string, double>> typeMix = {{"RoboCop", 1}};
+
+    Placement placement = UNIFORM;
+
+    /// @brief Number of clusters the robots are gathered around when using CLUSTERED placement
+    int clusterCount = 4;
+
+    /// @brief Standard deviation of the distance between a robot and its cluster center.
+    /// A value <= 0 picks 1/20th of the shorter board side
+    double clusterSpread = 0;
+
+    unsigned int seed = 0;
+
+    /// @brief Writes a config file generated from the parameters
+    /// @param output stream to write the config file to
+    /// @exception InvalidParameters thrown if the parameters cannot produce a valid config
+    void write(ostream &output) const;
+
+    /// @brief Generates a config file from the parameters
+    /// @return string containing the config file
+    /// @exception InvalidParameters thrown if the parameters cannot produce a valid config
+    string generate() const;
+
+    static bool isRobotType(const string &type);
+
+    /// @brief Parses a type mix such as "RoboCop=3,Terminator=1"
+    /// @param input the type mix string
+    /// @return list of robot types and their ratios
+    static vector<pair<string, double>> parseTypeMix(const string &input);
+
+    /// @brief Sets the parameter named by a command line option, so that every tool that
+    /// generates configs takes the same options (--width, --height, --turns, --robots,
+    /// --mix, --clustered & --spread). The seed is left to the tool
+    /// @param option the option, e.g. "--width"
+    /// @param value the option's value
+    /// @return false if the option is not a generator parameter
+    /// @exception logic_error thrown if the value is not a valid number
+    bool setOption(const string &option, const string &value);
+
+private:
+    vector<string> makeTypeList(mt19937 &generator) const;
+};
+
+inline bool ScenarioGenerator::isRobotType(const string &type)
+{
+    static const string ROBOT_TYPES[] = {"RoboCop", "Terminator", "TerminatorRoboCop", "BlueThunder",
+                                         "Madbot", "RoboTank", "UltimateRobot", "Nemesis"};
+
+    return find(begin(ROBOT_TYPES), end(ROBOT_TYPES), type) != end(ROBOT_TYPES);
+}
+
+inline vector<pair<string, double>> ScenarioGenerator::parseTypeMix(const string &input)
+{
+    vector<pair<string, double>> typeMix;
+    istringstream inputStream(input);
+    string entry;
+
+    while (getline(inputStream, entry, ','))
+    {
+        size_t separator = entry.find('=');
+
+        if (separator == string::npos)
+        {
+            typeMix.push_back({entry, 1});
+        }
+        else
+        {
+            typeMix.push_back({entry.substr(0, separator), stod(entry.substr(separator + 1))});
+        }
+    }
+
+    return typeMix;
+}
+
+inline bool ScenarioGenerator::setOption(const string &option, const string &value)
+{
+    if (option == "--width")
+        width = stoi(value);
+    else if (option == "--height")
+        height = stoi(value);
+    else if (option == "--turns")
+        turns = stoi(value);
+    else if (option == "--robots")
+        robotCount = stoi(value);
+    else if (option == "--mix")
+        typeMix = parseTypeMix(value);
+    else if (option == "--clustered")
+    {
+        placement = CLUSTERED;
+        clusterCount = stoi(value);
+    }
+    else if (option == "--spread")
+        clusterSpread = stod(value);
+    else
+        return false;
+
+    return true;
+}
+
+/// @brief Creates a shuffled list containing the type of every robot
+/// @details Every type gets floor(ratio * robotCount) robots and the robots
+///          that are left over go to the types with the largest remainders,
+///          so the counts match the ratios as closely as possible.
+/// @param generator random number generator used to shuffle the list
+/// @return list of robot types with robotCount elements
+inline vector<string> ScenarioGenerator::makeTypeList(mt19937 &generator) const
+{
+    double totalRatio = 0;
+    for (const auto &type : typeMix)
+    {
+        if (!isRobotType(type.first) || type.second < 0)
+        {
+            throw InvalidParameters();
+        }
+
+        totalRatio += type.second;
+    }
+
+    if (totalRatio <= 0)
+    {
+        throw InvalidParameters();
+    }
+
+    vector<long long> counts(typeMix.size());
+    vector<pair<double, int>> remainders;
+    long long assigned = 0;
+
+    for (size_t i = 0; i < typeMix.size(); i++)
+    {
+        double exactCount = typeMix[i].second / totalRatio * robotCount;
+        counts[i] = (long long)floor(exactCount);
+        assigned += counts[i];
+        remainders.push_back({exactCount - counts[i], (int)i});
+    }
+
+    // hand out the robots lost to rounding down, largest remainder first
+    stable_sort(remainders.begin(), remainders.end(), [](const pair<double, int> &a, const pair<double, int> &b) {
+        return a.first > b.first;
+    });
+
+    for (size_t i = 0; assigned < robotCount; i = (i + 1) % remainders.size(), assigned++)
+    {
+        counts[remainders[i].second]++;
+    }
+
+    vector<string> types;
+    types.reserve(robotCount);
+
+    for (size_t i = 0; i < typeMix.size(); i++)
+    {
+        types.insert(types.end(), counts[i], typeMix[i].first);
+    }
+
+    shuffle(types.begin(), types.end(), generator);
+
+    return types;
+}
+
+inline void ScenarioGenerator::write(ostream &output) const
+{
+    long long cellCount = (long long)width * height;
+
+    if (width <= 0 || height <= 0 || turns < 0 || robotCount < 0 || robotCount > cellCount ||
+        (placement == CLUSTERED && clusterCount <= 0))
+    {
+        throw InvalidParameters();
+    }
+
+    mt19937 generator(seed);
+    vector<string> types = makeTypeList(generator);
+
+    uniform_int_distribution<int> randomX(0, width - 1);
+    uniform_int_distribution<int> randomY(0, height - 1);
+
+    // Picking the cluster centers
+    vector<pair<int, int>> clusters;
+    if (placement == CLUSTERED)
+    {
+        for (int i = 0; i < clusterCount; i++)
+        {
+            clusters.push_back({randomX(generator), randomY(generator)});
+        }
+    }
+
+    double spread = clusterSpread > 0 ? clusterSpread : max(1.0, min(width, height) / 20.0);
+    normal_distribution<double> randomOffset(0, spread);
+    uniform_int_distribution<int> randomCluster(0, max(0, clusterCount - 1));
+
+    /// @brief cell index (y * width + x) of every occupied position
+    unordered_set<long long> usedPositions;
+    usedPositions.reserve(robotCount);
+
+    output << "M by N : " << width << ' ' << height << '\n';
+    output << "turns: " << turns << '\n';
+    output << "robots: " << robotCount << '\n';
+
+    string line;
+
+    for (int i = 0; i < robotCount; i++)
+    {
+        int posX;
+        int posY;
+        int attempts = 0;
+
+        do
+        {
+            // Clustered placement gives up on the cluster after a number of
+            // attempts so that crowded clusters cannot stall the generator
+            if (placement == CLUSTERED && attempts < 64)
+            {
+                const pair<int, int> &center = clusters[randomCluster(generator)];
+                posX = min(width - 1, max(0, center.first + (int)lround(randomOffset(generator))));
+                posY = min(height - 1, max(0, center.second + (int)lround(randomOffset(generator))));
+            }
+            else
+            {
+                posX = randomX(generator);
+                posY = randomY(generator);
+            }
+
+            attempts++;
+        } while (!usedPositions.insert((long long)posY * width + posX).second);
+
+        line = types[i];
+        line += ' ';
+        line += types[i];
+        line += to_string(i);
+        line += ' ';
+        line += to_string(posX);
+        line += ' ';
+        line += to_string(posY);
+        line += '\n';
+
+        output << line;
+    }
+}
+
+inline string ScenarioGenerator::generate() const
+{
+    ostringstream output;
+    write(output);
+
+    return output.str();
+}
+
+#endif
@@ -0,0 +1,382 @@
+/*
+ *
+ * This file contains the classes robots use to decide their actions in a
+ * simultaneous turn (see simultaneous.h)
+ *
+ * --- Code Summary ---
+ * In a simultaneous turn every robot decides what it wants to do before any
+ * robot acts, so the decisions can be made on many threads at once. A robot
+ * decides against a TurnView, a read-only picture of the board (or of the
+ * part of it around the robots being decided) at the start of the turn, and
+ * writes its decision into a TurnIntent: the robots it spotted, the cell it
+ * moves to, whether it tramples and the cells it fires at. Nothing shared is
+ * changed while deciding.
+ *
+ * The random numbers a robot uses come from its own IntentRandom, which draws
+ * from the robot's Philox stream for the turn (see RNG::turnStreams()), keyed
+ * on the robot's id. A turn then plays out the same no matter how many threads
+ * decide it or in which order the robots are decided, and with counter-based
+ * streams a robot draws the same numbers as it would in a sequential turn.
+ *
+ * A TurnView stores its robots in one array, bucketed by square tiles of about
+ * one robot each, with the tiles laid out along a Hilbert curve. Robots that
+ * stand near each other on the board are then stored near each other in
+ * memory, wherever they are in the robot queue, so looking at the cells around
+ * a robot reads a few neighbouring tiles. Deciding the robots in the order the
+ * view stores them finds those tiles in cache most of the time, where a hash
+ * of the cells (or the robot queue order) would miss the cache on almost every
+ * look once the board no longer fits in it.
+ *
+ */
+
+#ifndef INTENT_H
+#define INTENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "board.h"
+#include "random.h"
+#include "robotbase.h"
+
+using namespace std;
+
+/// @brief Everything a robot decided to do in a simultaneous turn
+struct TurnIntent
+{
+    static const int MAX_SPOTTED = 8;
+    static constexpr int MAX_SHOTS = 3;
+
+    /// @brief robots seen in adjacent cells, only used for the action log
+    Robot *spotted[MAX_SPOTTED];
+    int spottedCount = 0;
+
+    /// @brief cell the robot moves to
+    bool isMoving = false;
+    int moveX = 0;
+    int moveY = 0;
+
+    /// @brief true if the robot tramples whatever robot it shares its cell with after moving
+    bool isTrampling = false;
+
+    /// @brief cells the robot fires at, in order
+    int shotX[MAX_SHOTS];
+    int shotY[MAX_SHOTS];
+    int shotCount = 0;
+
+    /// @brief true if the robot evolves at the end of the turn once it is ready to
+    bool evolvesWhenReady = false;
+
+    void spot(Robot *robot)
+    {
+        if (spottedCount < MAX_SPOTTED)
+        {
+            spotted[spottedCount++] = robot;
+        }
+    }
+
+    void moveTo(int posX, int posY)
+    {
+        isMoving = true;
+        moveX = posX;
+        moveY = posY;
+    }
+
+    void fireAt(int posX, int posY)
+    {
+        if (shotCount < MAX_SHOTS)
+        {
+            shotX[shotCount] = posX;
+            shotY[shotCount] = posY;
+            shotCount++;
+        }
+    }
+};
+
+/// @brief Random number generator of one robot in one simultaneous turn
+class IntentRandom
+{
+private:
+    PhiloxStream stream;
+
+public:
+    /// @param streams streams of the turn
+    /// @param robotId the robot's id, see Robot::getId()
+    IntentRandom(const TurnStreams &streams, int robotId)
+    {
+        streams.select(stream, robotId);
+    }
+
+    /// @brief Generates a random integer value in the range [min, max]. min & max are inclusive
+    int integer(int min, int max)
+    {
+        uniform_int_distribution<int> distribution(min, max);
+
+        return distribution(stream);
+    }
+
+    /// @brief Picks random cells on the board, all at once (see RNG::cells())
+    void cells(int count, int *cellX, int *cellY)
+    {
+        randomCells(stream, Board::getWidth(), Board::getHeight(), count, cellX, cellY);
+    }
+};
+
+/// @brief The board as it is at the start of a simultaneous turn
+class TurnView
+{
+public:
+    /// @brief A robot stored in the view
+    struct Entry
+    {
+        int posX;
+        int posY;
+
+        /// @brief position of the robot in the robot queue
+        int robotIndex;
+
+        Robot *robot;
+    };
+
+private:
+    /// @brief robots in the order they were added
+    vector<Entry> added;
+
+    /// @brief robots tile by tile, the tiles in Hilbert curve order
+    vector<Entry> entries;
+
+    /// @brief the tiles cover the width of the board & rows [firstRow, lastRow]
+    int width = 0;
+    int firstRow = 0;
+    int lastRow = -1;
+
+    /// @brief tiles are (1 << tileShift) cells wide & high
+    int tileShift = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+
+    /// @brief the robots of tile i (tiles numbered row by row) are entries[tileStart[i], tileEnd[i])
+    vector<int> tileStart;
+    vector<int> tileEnd;
+
+    /// @brief every tile, numbered row by row, in Hilbert curve order. Only rebuilt when the number of tiles changes
+    vector<int> curveOrder;
+    int curveTilesX = 0;
+    int curveTilesY = 0;
+
+    TurnStreams streams;
+
+    /// @brief cells occupied at the start of the turn for targeted fire, nullptr without it
+    const SpatialIndex *occupiedCells = nullptr;
+
+    static uint64_t hilbertIndex(int order, int posX, int posY);
+
+    void orderTiles();
+
+public:
+    static long long cellKey(int posX, int posY)
+    {
+        return (long long)posY * Board::getWidth() + posX;
+    }
+
+    /// @brief Removes every robot from the view
+    /// @param streams random number streams of the robots for this turn
+    /// @param firstRow first row of the board the robots added stand in
+    /// @param lastRow last row of the board the robots added stand in (inclusive)
+    /// @param expectedCount number of robots that will be added
+    /// @param occupiedCells cells occupied by every robot on the board, nullptr without targeted fire
+    void reset(const TurnStreams &streams, int firstRow, int lastRow, int expectedCount, const SpatialIndex *occupiedCells);
+
+    /// @brief Adds a robot at its current position. Robots must be added in robot
+    /// queue order, so that the earliest robot is kept where robots share a cell
+    /// @param robot robot to add
+    /// @param robotIndex position of the robot in the robot queue
+    void add(Robot *robot, int robotIndex);
+
+    /// @brief Sorts the robots added into their tiles. Must be called after the last
+    /// robot is added & before the view is looked at
+    void arrange();
+
+    /// @brief Calls visit(entry) for every robot in the view, in the order they are stored
+    /// (along the Hilbert curve). Visiting robots in this order keeps the cells around
+    /// consecutive robots in cache
+    template <typename Visit>
+    void forEachRobot(Visit visit) const;
+
+    static bool isInside(int posX, int posY)
+    {
+        return posX >= 0 && posX < Board::getWidth() && posY >= 0 && posY < Board::getHeight();
+    }
+
+    /// @return the robot on a cell at the start of the turn, nullptr if the cell was empty
+    Robot *occupant(int posX, int posY) const;
+
+    /// @return the cells occupied by every robot on the board (not only the robots in the
+    /// view) at the start of the turn, nullptr if the game does not play with targeted fire
+    const SpatialIndex *getOccupiedCells() const
+    {
+        return occupiedCells;
+    }
+
+    /// @param robotId the robot's id, see Robot::getId()
+    /// @return the random number generator of that robot for this turn
+    IntentRandom randomFor(int robotId) const
+    {
+        return IntentRandom(streams, robotId);
+    }
+};
+
+/// @brief Position of a cell along the Hilbert curve filling a (1 << order) x (1 << order) square
+inline uint64_t TurnView::hilbertIndex(int order, int posX, int posY)
+{
+    uint64_t index = 0;
+
+    for (int half = 1 << (order - 1); half > 0; half >>= 1)
+    {
+        int quadrantX = (posX & half) > 0;
+        int quadrantY = (posY & half) > 0;
+        index += (uint64_t)half * half * ((3 * quadrantX) ^ quadrantY);
+
+        // rotate the quadrant, so the curve leaving one quadrant enters the next
+        if (quadrantY == 0)
+        {
+            if (quadrantX == 1)
+            {
+                posX = half - 1 - (posX & (half - 1));
+                posY = half - 1 - (posY & (half - 1));
+            }
+
+            swap(posX, posY);
+        }
+    }
+
+    return index;
+}
+
+/// @brief Lists the tiles in Hilbert curve order, once for every number of tiles
+inline void TurnView::orderTiles()
+{
+    if (tilesX == curveTilesX && tilesY == curveTilesY)
+    {
+        return;
+    }
+
+    int order = 1;
+    while ((1 << order) < max(tilesX, tilesY))
+    {
+        order++;
+    }
+
+    vector<pair<uint64_t, int>> tiles;
+    tiles.reserve(tilesX * tilesY);
+
+    for (int tileY = 0; tileY < tilesY; tileY++)
+    {
+        for (int tileX = 0; tileX < tilesX; tileX++)
+        {
+            tiles.push_back({hilbertIndex(order, tileX, tileY), tileY * tilesX + tileX});
+        }
+    }
+
+    sort(tiles.begin(), tiles.end());
+
+    curveOrder.resize(tiles.size());
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        curveOrder[i] = tiles[i].second;
+    }
+
+    curveTilesX = tilesX;
+    curveTilesY = tilesY;
+}
+
+inline void TurnView::reset(const TurnStreams &streams, int firstRow, int lastRow, int expectedCount, const SpatialIndex *occupiedCells)
+{
+    this->streams = streams;
+    this->occupiedCells = occupiedCells;
+    this->firstRow = firstRow;
+    this->lastRow = lastRow;
+
+    this->width = Board::getWidth();
+
+    int columns = max(width, 1);
+    int rows = max(lastRow - firstRow + 1, 1);
+
+    tileShift = SpatialIndex::tileShiftFor(columns, rows, expectedCount);
+    tilesX = ((columns - 1) >> tileShift) + 1;
+    tilesY = ((rows - 1) >> tileShift) + 1;
+
+    added.clear();
+    added.reserve(expectedCount);
+}
+
+inline void TurnView::add(Robot *robot, int robotIndex)
+{
+    added.push_back({robot->getPositionX(), robot->getPositionY(), robotIndex, robot});
+}
+
+inline void TurnView::arrange()
+{
+    orderTiles();
+
+    // Counting sort: count the robots of every tile, give every tile its place along the
+    // curve, then copy the robots in, keeping the order they were added in within a tile
+    tileEnd.assign(tilesX * tilesY, 0);
+    tileStart.resize(tilesX * tilesY);
+
+    for (const Entry &entry : added)
+    {
+        tileEnd[((entry.posY - firstRow) >> tileShift) * tilesX + (entry.posX >> tileShift)]++;
+    }
+
+    int start = 0;
+    for (int tile : curveOrder)
+    {
+        tileStart[tile] = start;
+        start += tileEnd[tile];
+
+        // tileEnd counts up from the start again while the robots are copied in
+        tileEnd[tile] = tileStart[tile];
+    }
+
+    entries.resize(added.size());
+
+    for (const Entry &entry : added)
+    {
+        entries[tileEnd[((entry.posY - firstRow) >> tileShift) * tilesX + (entry.posX >> tileShift)]++] = entry;
+    }
+}
+
+template <typename Visit>
+inline void TurnView::forEachRobot(Visit visit) const
+{
+    for (const Entry &entry : entries)
+    {
+        visit(entry);
+    }
+}
+
+inline Robot *TurnView::occupant(int posX, int posY) const
+{
+    if (posY < firstRow || posY > lastRow || posX < 0 || posX >= width)
+    {
+        return nullptr;
+    }
+
+    int tile = ((posY - firstRow) >> tileShift) * tilesX + (posX >> tileShift);
+
+    // the first robot on the cell is the earliest in the robot queue
+    for (int i = tileStart[tile]; i < tileEnd[tile]; i++)
+    {
+        if (entries[i].posX == posX && entries[i].posY == posY)
+        {
+            return entries[i].robot;
+        }
+    }
+
+    return nullptr;
+}
+
+#endif
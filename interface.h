@@ -8,16 +8,46 @@
 #ifndef INTERFACE_H
 #define INTERFACE_H
 
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include "random.h"
 #include "board.h"
 #include "robot.h"
+#include "config.h"
+#include "scenario.h"
+#include "checkpoint.h"
+#include "replay.h"
+#include "pipeline.h"
+#include "render.h"
+#include "simultaneous.h"
+#include "terminal.h"
+#include "profiler.h"
+#include "tracer.h"
 
 using namespace std;
 
+/// @brief The contents of a text config, binary scenario or checkpoint held in memory,
+/// e.g. the output of a ScenarioGenerator, that a Game is started from without a file
+struct InMemoryConfig
+{
+    string_view contents;
+};
+
 class Game
 {
 private:
@@ -29,20 +59,99 @@ private:
     /// @brief The game board
     Board board;
     
-    /// @brief Temporarily stores the interface as a string before
-    /// outputting to the terminal
+    /// @brief Temporarily stores the interface up to the board before outputting
+    /// to the terminal. Reused on every turn, so it only allocates while it grows.
+    /// The board is written straight from the board's own buffer
     string displayBuffer = "";
 
-    /// @brief The file that is used to log all game output
-    ofstream logFile;
+    /// @brief The file that is used to log all game output, -1 if it is not open
+    int logFileDescriptor = -1;
     
-    /// @brief The text file that stores a template of the interface
-    ifstream interfaceTemplate;
+    /// @brief The text of interface.template between its ' markers, read once
+    /// when the game starts. The game data is displayed at the markers
+    vector<string> interfaceParts;
+
+    /// @brief Number of parts in interfaceParts: the text before the turn, alive
+    /// count, revive count, action log & board
+    static const int INTERFACE_PART_COUNT = 5;
+
+    /// @brief Largest number of parts written by writeGathered()
+    static constexpr int MAX_OUTPUT_PARTS = 4;
 
     /// @brief Stores the game logs that will be displayed on every turn
     Log actionLog;
 
-    void readConfigFile(ifstream &configFile);
+    /// @brief Records every turn into game.replay
+    ReplayWriter replayWriter;
+
+    /// @brief The turn that is being captured for the display
+    TurnSnapshot currentTurn;
+
+    /// @brief Decides which turns are displayed
+    RenderPolicy renderPolicy;
+
+    /// @brief Decides which part of the board is displayed
+    BoardView boardView;
+
+    /// @brief Last known position of the robot followed by boardView
+    int followedX = 0;
+    int followedY = 0;
+
+    /// @brief true if the interface is redrawn in place on an ANSI terminal
+    /// instead of being printed again below the last turn
+    bool isAnsiOutput = false;
+
+    /// @brief The last frame drawn on the terminal when isAnsiOutput is true
+    TerminalScreen terminalScreen;
+
+    /// @brief The interface as drawn on the terminal, with the action log padded to actionLogRows lines
+    string terminalBuffer;
+
+    /// @brief Largest number of action log lines shown so far. The action log is
+    /// padded to this many lines so that the board does not move up & down
+    int actionLogRows = 0;
+
+    /// @brief Robot::killCount & Robot::evolveCount at the start of the current turn
+    long long turnStartKillCount = 0;
+    long long turnStartEvolveCount = 0;
+
+    /// @brief Turns waiting for the render thread, nullptr if the game is
+    /// displayed on the thread playing it
+    unique_ptr<SnapshotQueue<TurnSnapshot>> renderQueue;
+    thread renderThread;
+
+    /// @brief true if turns are played with the simultaneous rules (see simultaneous.h)
+    bool isSimultaneous = false;
+    SimultaneousTurn simultaneousTurn;
+
+    /// @brief true if RoboCops & TerminatorRoboCops fire at the robots in their fire range
+    /// (see Game::setTargetedFire), and if Terminators & TerminatorRoboCops hunt the nearest
+    /// robot (see Game::setHunting). Both find the robots in occupiedCells
+    bool isTargetedFire = false;
+    bool isHunting = false;
+    SpatialIndex occupiedCells;
+
+    /// @brief Cells robots may stand on (see Robot::occupiedBits), rebuilt at the start of every
+    /// turn on boards of at most MAX_BITBOARD_CELLS cells, which it takes 1 bit per cell to keep
+    Bitboard occupiedBits;
+    static const long long MAX_BITBOARD_CELLS = 1LL << 24;
+
+    /// @brief A headless game does not display, log or trace anything. Used
+    /// for branches of a game that are only played for their outcome
+    bool isHeadless = false;
+
+    void readConfigFile(string_view configText);
+    void loadContents(string_view contents);
+    void loadScenario(const Scenario &scenario);
+    void restoreState(const GameState &state);
+    void openOutputFiles();
+    void indexOccupiedCells();
+    void markOccupiedCells();
+    void captureTurn(TurnSnapshot &snapshot);
+    void render(const TurnSnapshot &snapshot);
+
+    static void appendNumber(string &buffer, long long number);
+    static void writeGathered(int fileDescriptor, const iovec *parts, int partCount);
 
     // Exception Classes
     
@@ -52,8 +161,67 @@ private:
     };
 
 public:
-    Game(ifstream &configFile);
+    /// @brief Exception that occurs when a checkpoint file could not be written
+    class CheckpointSavingError
+    {
+    };
+
+    Game(const InMemoryConfig &config, bool isHeadless = false);
+    Game(const string &configFilename, bool isHeadless = false);
+    Game(const GameState &state, bool isHeadless = false);
+    ~Game();
+
+    /// @brief Captures the complete state of the game. Only valid between turns
+    /// @return the game state
+    GameState getState() const;
+
+    /// @brief Saves the complete state of the game so that it can be resumed later
+    /// @param filename path of the checkpoint file
+    /// @exception CheckpointSavingError thrown if the checkpoint could not be written
+    void saveCheckpoint(const string &filename) const;
+
+
+    int getTurn() const;
+
+    /// @brief Sets which turns are displayed. Turns that are not displayed
+    /// skip the board refresh and the interface
+    /// @param policy the render policy
+    void setRenderPolicy(const RenderPolicy &policy);
+
+    /// @brief Sets which part of the board is displayed
+    /// @param view the board view
+    void setBoardView(const BoardView &view);
+
+    /// @brief Redraws the interface in place on an ANSI terminal, writing only the
+    /// characters that changed since the last displayed turn. game.log is not affected
+    /// @param isAnsiOutput true to redraw in place, false to print every turn below the last one
+    void setAnsiOutput(bool isAnsiOutput);
+
+    /// @brief Chooses the rules every later turn is played with. With the simultaneous
+    /// rules all robots decide their actions at the same time, on several threads
+    /// @param isSimultaneous true for the simultaneous rules, false for robots acting one after another
+    /// @param threadCount number of threads deciding the robots' actions, 0 for one per core
+    void setSimultaneousTurns(bool isSimultaneous, int threadCount = 0);
+
+    /// @brief Lets RoboCops & TerminatorRoboCops fire at robots within their fire range
+    /// instead of at random cells in it, so that games on large sparse boards end sooner.
+    /// Shots left over when fewer robots are in range are fired at random cells as before
+    /// @param isTargetedFire true to fire at robots, false to fire at random cells
+    void setTargetedFire(bool isTargetedFire);
+
+    /// @brief Lets Terminators & TerminatorRoboCops that see no robot next to them step
+    /// toward the nearest robot instead of to a random cell, so that the last robots on a
+    /// large board find each other sooner
+    /// @param isHunting true to step toward the nearest robot, false to step at random
+    void setHunting(bool isHunting);
 
+    /// @brief Displays the game on a separate render thread from now on, so that the
+    /// next turn is played while the last one is being displayed
+    /// @param queueCapacity number of played turns that may wait to be displayed
+    void startRenderThread(int queueCapacity = 4);
+
+    /// @brief Waits until every played turn has been displayed and stops the render thread
+    void stopRenderThread();
 
     void nextTurn();
     void updateInterface();
@@ -63,130 +231,452 @@ public:
 };
 
 /// @brief Reads in values from the game's initial config file
-/// @param configFile reference to the config file ifstream object
-inline void Game::readConfigFile(ifstream &configFile)
+/// @param configText contents of the config file
+/// @exception ConfigParser::ConfigError thrown if the config file is invalid
+inline void Game::readConfigFile(string_view configText)
 {
-    string input;
+    ConfigParser parser(configText);
+    parser.parseHeader();
 
     // Read in board width & height
-    getline(configFile, input);
-    input = input.substr(9);
-    board.setWidth(stoi(input.substr(0, input.find(' '))));
-    board.setHeight(stoi(input.substr(input.find(' ') + 1)));
+    board.setWidth(parser.getWidth());
+    board.setHeight(parser.getHeight());
 
     // Initialize random number generator
     RNG::init(board.getWidth(), board.getHeight());
 
     // Read in turn limit
-    getline(configFile, input);
-    turnLimit = stoi(input.substr(7));
+    turnLimit = parser.getTurnLimit();
 
-    // Read in number of robots
-    int robotCount = 0;
-    getline(configFile, input);
-    robotCount = stoi(input.substr(8));
+    // Allocate space for every robot up front
+    Robot::robotDeque.reserve(Robot::robotDeque.size() + parser.getRobotCount());
 
-    string robotType;
-    string robotName;
-    int posX;
-    int posY;
+    // the robots are numbered from 0 in the order of the config
+    Robot::setNextId(0);
 
     // Read in each robot
-    for (int i = robotCount; i > 0; i--)
+    ConfigParser::RobotEntry entry;
+    try
     {
-        getline(configFile, robotType, ' ');
-        getline(configFile, robotName, ' ');
+        while (parser.nextRobot(entry))
+        {
+            int posX = entry.posX;
+            int posY = entry.posY;
 
-        getline(configFile, input, ' ');
-        if (input == "random")
-            posX = RNG::posX();
-        else
-            posX = stoi(input);
+            RNG::selectStream(0, Robot::getNextId());
 
-        getline(configFile, input, '\n');
-        if (input == "random")
-            posY = RNG::posY();
-        else
-            posY = stoi(input);
-        
-        
-        if (robotType == "RoboCop")
-        {
-            Robot::robotDeque.push_back(new RoboCop(robotName, posX, posY));
-        }
-        else if (robotType == "Terminator")
-        {
-            Robot::robotDeque.push_back(new Terminator(robotName, posX, posY));
+            if (posX == ConfigParser::RANDOM_POSITION)
+                posX = RNG::posX();
+
+            if (posY == ConfigParser::RANDOM_POSITION)
+                posY = RNG::posY();
+
+            Robot::robotDeque.push_back(createRobot(entry.type, string(entry.name), posX, posY));
         }
-        else if (robotType == "TerminatorRoboCop")
+    }
+    catch (ConfigParser::ConfigError)
+    {
+        // The destructor is not called when the constructor fails,
+        // so the robots that were already created are deleted here
+        while (!Robot::robotDeque.is_empty())
         {
-            Robot::robotDeque.push_back(new TerminatorRoboCop(robotName, posX, posY));
+            delete Robot::robotDeque.pop_back();
         }
-        else if (robotType == "BlueThunder")
+
+        throw;
+    }
+}
+
+/// @brief Reads in values from a binary scenario
+/// @param scenario the binary scenario
+/// @exception Scenario::InvalidScenario thrown if a robot record is invalid
+inline void Game::loadScenario(const Scenario &scenario)
+{
+    board.setWidth(scenario.getWidth());
+    board.setHeight(scenario.getHeight());
+
+    RNG::init(board.getWidth(), board.getHeight());
+
+    turnLimit = scenario.getTurnLimit();
+
+    Robot::robotDeque.reserve(Robot::robotDeque.size() + scenario.getRobotCount());
+
+    // the robots are numbered from 0 in the order of the scenario
+    Robot::setNextId(0);
+
+    try
+    {
+        for (int i = 0; i < scenario.getRobotCount(); i++)
         {
-            Robot::robotDeque.push_back(new BlueThunder(robotName, posX, posY));
+            const RobotRecord &record = scenario.getRobot(i);
+            int posX = record.posX;
+            int posY = record.posY;
+
+            RNG::selectStream(0, Robot::getNextId());
+
+            if (posX == ConfigParser::RANDOM_POSITION)
+                posX = RNG::posX();
+
+            if (posY == ConfigParser::RANDOM_POSITION)
+                posY = RNG::posY();
+
+            if (posX < 0 || posX >= board.getWidth() || posY < 0 || posY >= board.getHeight())
+            {
+                throw Scenario::InvalidScenario();
+            }
+
+            Robot *robot = createRobot((RobotType)record.type, string(scenario.getName(record)), posX, posY);
+
+            if (robot == nullptr)
+            {
+                throw Scenario::InvalidScenario();
+            }
+
+            Robot::robotDeque.push_back(robot);
         }
-        else if (robotType == "Madbot")
+    }
+    catch (Scenario::InvalidScenario)
+    {
+        // The destructor is not called when the constructor fails,
+        // so the robots that were already created are deleted here
+        while (!Robot::robotDeque.is_empty())
         {
-            Robot::robotDeque.push_back(new Madbot(robotName, posX, posY));
+            delete Robot::robotDeque.pop_back();
         }
-        else if (robotType == "RoboTank")
+
+        throw;
+    }
+}
+
+/// @brief Recreates the turn counters, board, robot queues & random number
+/// generator from a saved state
+/// @param state the saved state
+/// @exception GameState::InvalidCheckpoint thrown if a saved robot or the random number generator's state is invalid
+inline void Game::restoreState(const GameState &state)
+{
+    if (!state.randomState.empty() && !RNG::isValidState(state.randomState))
+    {
+        throw GameState::InvalidCheckpoint();
+    }
+
+    turn = state.turn;
+    turnLimit = state.turnLimit;
+
+    board.setWidth(state.width);
+    board.setHeight(state.height);
+    RNG::init(state.width, state.height);
+
+    Robot::robotDeque.reserve(Robot::robotDeque.size() + state.robots.size());
+
+    try
+    {
+        for (const RobotState &robot : state.robots)
         {
-            Robot::robotDeque.push_back(new RoboTank(robotName, posX, posY));
+            Robot::robotDeque.push_back(state.restoreRobot(robot));
         }
-        else if (robotType == "UltimateRobot")
+
+        for (const RobotState &robot : state.revivingRobots)
         {
-            Robot::robotDeque.push_back(new UltimateRobot(robotName, posX, posY));
+            Robot::reviveDeque.push_back(state.restoreRobot(robot));
         }
-        else if (robotType == "Nemesis")
+    }
+    catch (GameState::InvalidCheckpoint)
+    {
+        // The destructor is not called when the constructor fails,
+        // so the robots that were already created are deleted here
+        while (!Robot::robotDeque.is_empty())
         {
-            Robot::robotDeque.push_back(new Nemesis(robotName, posX, posY));
+            delete Robot::robotDeque.pop_back();
         }
-        else
+
+        while (!Robot::reviveDeque.is_empty())
         {
-            cout << "[ERROR] The robot type " << robotType << " could not be interpreted\n";
+            delete Robot::reviveDeque.pop_back();
         }
+
+        throw;
+    }
+
+    // the restored robots keep their saved ids, & robots created later continue from the saved count
+    Robot::setNextId(state.nextRobotId);
+
+    if (state.randomState.empty())
+    {
+        RNG::seed(state.randomSeed);
+    }
+    else
+    {
+        RNG::setState(state.randomState);
     }
 }
 
-inline Game::Game(ifstream &configFile)
+/// @brief Opens the files the game writes to & reads from on every turn
+inline void Game::openOutputFiles()
 {
-    readConfigFile(configFile);
-
-    // Open in default mode to clear log file
-    logFile.open("game.log");
+    // Clear the log file and open it in append mode
+    logFileDescriptor = open("game.log", O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
 
-    if (!logFile.is_open())
+    if (logFileDescriptor < 0)
     {
         throw LogFileOpeningError();
     }
 
-    logFile.close();
+    // Split the interface template at its markers. A missing template displays only the game data
+    ifstream interfaceTemplate("interface.template");
+    string part;
+
+    while (getline(interfaceTemplate, part, '\''))
+    {
+        interfaceParts.push_back(part);
+    }
+
+    interfaceParts.resize(INTERFACE_PART_COUNT);
 
-    // Open log file in append mode
-    logFile.open("game.log", ofstream::app);
+    replayWriter.open("game.replay", board.getWidth(), board.getHeight());
 
-    if (!logFile.is_open())
+    TRACE_OPEN("trace.json");
+}
+
+/// @brief Starts a game from a config held in memory, without reading any file
+/// @param config text config, binary scenario or checkpoint
+/// @param isHeadless true if the game should not display, log or trace anything
+/// @exception ConfigParser::ConfigError thrown if the text config is invalid
+/// @exception Scenario::InvalidScenario thrown if the binary scenario is invalid
+/// @exception GameState::InvalidCheckpoint thrown if the checkpoint is invalid
+inline Game::Game(const InMemoryConfig &config, bool isHeadless)
+{
+    this->isHeadless = isHeadless;
+
+    loadContents(config.contents);
+
+    if (!isHeadless)
     {
-        throw LogFileOpeningError();
+        openOutputFiles();
+    }
+}
+
+/// @param configFilename path of a text config, binary scenario or checkpoint file,
+/// which is memory mapped while it is read
+/// @param isHeadless true if the game should not display, log or trace anything
+/// @exception MappedFile::OpeningError thrown if the config file could not be opened
+/// @exception ConfigParser::ConfigError thrown if the text config is invalid
+/// @exception Scenario::InvalidScenario thrown if the binary scenario is invalid
+/// @exception GameState::InvalidCheckpoint thrown if the checkpoint is invalid
+inline Game::Game(const string &configFilename, bool isHeadless)
+{
+    this->isHeadless = isHeadless;
+
+    MappedFile configFile(configFilename);
+    loadContents(configFile.getText());
+
+    if (!isHeadless)
+    {
+        openOutputFiles();
+    }
+}
+
+/// @brief Sets the game up from a text config, binary scenario or checkpoint,
+/// telling them apart by their first bytes
+inline void Game::loadContents(string_view contents)
+{
+    if (Scenario::isScenario(contents))
+    {
+        loadScenario(Scenario(contents));
+    }
+    else if (GameState::isCheckpoint(contents))
+    {
+        restoreState(GameState::read(contents));
+    }
+    else
+    {
+        readConfigFile(contents);
+    }
+}
+
+/// @brief Resumes a game from a saved state
+/// @param state the saved state
+/// @param isHeadless true if the game should not display, log or trace anything
+/// @exception GameState::InvalidCheckpoint thrown if the state is invalid
+inline Game::Game(const GameState &state, bool isHeadless)
+{
+    this->isHeadless = isHeadless;
+
+    restoreState(state);
+
+    if (!isHeadless)
+    {
+        openOutputFiles();
+    }
+}
+
+/// @brief Deletes every robot left in the robot queues so that another game
+/// can be started afterwards
+inline Game::~Game()
+{
+    stopRenderThread();
+
+    setTargetedFire(false);
+    setHunting(false);
+
+    if (Robot::occupiedBits == &occupiedBits)
+    {
+        Robot::occupiedBits = nullptr;
+    }
+
+    while (!Robot::robotDeque.is_empty())
+    {
+        delete Robot::robotDeque.pop_back();
+    }
+
+    while (!Robot::reviveDeque.is_empty())
+    {
+        delete Robot::reviveDeque.pop_back();
+    }
+
+    actionLog.resetLog();
+
+    if (logFileDescriptor >= 0)
+    {
+        close(logFileDescriptor);
+    }
+
+    if (!isHeadless)
+    {
+        PROFILE_REPORT(cerr);
+        TRACE_CLOSE();
+    }
+}
+
+inline GameState Game::getState() const
+{
+    GameState state;
+    state.turn = turn;
+    state.turnLimit = turnLimit;
+    state.width = board.getWidth();
+    state.height = board.getHeight();
+    state.nextRobotId = Robot::getNextId();
+
+    vector<string> names;
+
+    /// @brief index in names of every name that has been stored
+    unordered_map<string, int> nameIndexes;
+
+    auto captureQueue = [&](Deque<Robot *> &queue, vector<RobotState> &robots) {
+        robots.reserve(queue.size());
+
+        for (int i = 0; i < queue.size(); i++)
+        {
+            auto name = nameIndexes.insert({queue[i]->getName(), (int)names.size()});
+            if (name.second)
+            {
+                names.push_back(queue[i]->getName());
+            }
+
+            robots.push_back(GameState::captureRobot(queue[i], name.first->second));
+        }
+    };
+
+    captureQueue(Robot::robotDeque, state.robots);
+    captureQueue(Robot::reviveDeque, state.revivingRobots);
+
+    state.names = make_shared<const vector<string>>(move(names));
+
+    state.randomState = RNG::getState();
+
+    return state;
+}
+
+inline int Game::getTurn() const
+{
+    return turn;
+}
+
+/// @details The checkpoint is written to a temporary file first and then renamed,
+/// so an existing checkpoint is never left half written if the program is stopped
+inline void Game::saveCheckpoint(const string &filename) const
+{
+    string temporaryFilename = filename + ".tmp";
+
+    {
+        ofstream checkpointFile(temporaryFilename, ofstream::binary);
+
+        if (!checkpointFile.is_open())
+        {
+            throw CheckpointSavingError();
+        }
+
+        getState().write(checkpointFile);
+
+        if (!checkpointFile.good())
+        {
+            throw CheckpointSavingError();
+        }
+    }
+
+    if (rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+    {
+        throw CheckpointSavingError();
     }
-    
-    interfaceTemplate.open("interface.template");
 }
 
 /// @brief Executes the next game turn
 inline void Game::nextTurn()
 {
+    PROFILE_SCOPE(Profiler::TURN);
+    TRACE_SCOPE("Game::nextTurn", "\"turn\":" + to_string(turn));
+
+    turnStartKillCount = Robot::killCount;
+    turnStartEvolveCount = Robot::evolveCount;
+
+    markOccupiedCells();
+
     // Checking for any robots queued for a revive
     if (Robot::reviveDeque.size() > 0) {
+        PROFILE_SCOPE(Profiler::REVIVE);
         revive();
     }
 
+    if (isTargetedFire || isHunting)
+    {
+        indexOccupiedCells();
+    }
+
+    if (isSimultaneous)
+    {
+        PROFILE_SCOPE(Profiler::SIMULTANEOUS_TURN);
+        simultaneousTurn.play(turn);
+    }
+    else
+    {
+        while (Robot::robotDeque.front()->getNextTurn() == turn)
+        {
+            int actingId = Robot::robotDeque.front()->getId();
+
+            RNG::selectStream(turn, actingId);
+
+            {
+                PROFILE_SCOPE(Profiler::executeTurnPhase(Robot::robotDeque.front()->getType()));
+                TRACE_SCOPE("executeTurn", Tracer::robotArgs(Robot::robotDeque.front()->getName(), Robot::robotDeque.front()->getType()));
+                Robot::robotDeque.front()->executeTurn();
+            }
+
+            // a robot that evolved was replaced by a new robot with a new id on the same cell
+            if (Robot::occupiedCells != nullptr && Robot::robotDeque.front()->getId() != actingId)
+            {
+                Robot *evolved = Robot::robotDeque.front();
+                occupiedCells.remove(evolved->getPositionX(), evolved->getPositionY(), actingId);
+                occupiedCells.insert(evolved->getPositionX(), evolved->getPositionY(), evolved->getId());
+            }
+
+            Robot::robotDeque.push_back(Robot::robotDeque.pop_front());
+        }
+    }
 
-    while (Robot::robotDeque.front()->getNextTurn() == turn)
+    if (!isHeadless)
     {
-        Robot::robotDeque.front()->executeTurn();
-        Robot::robotDeque.push_back(Robot::robotDeque.pop_front());
+        PROFILE_SCOPE(Profiler::REPLAY_RECORDING);
+        TRACE_SCOPE("replay record");
+        replayWriter.record(turn, actionLog.getLog());
     }
     
     updateInterface();
@@ -194,93 +684,409 @@ inline void Game::nextTurn()
     turn++;
 }
 
+/// @brief Captures everything the interface shows for the turn that has just been played
+/// @param snapshot the snapshot the turn is written to
+inline void Game::captureTurn(TurnSnapshot &snapshot)
+{
+    snapshot.turn = turn;
+    snapshot.aliveCount = Robot::robotDeque.size();
+    snapshot.revivingCount = Robot::reviveDeque.size();
+    snapshot.actionLog = actionLog.getLog();
+    Board::captureRobots(snapshot.robots);
+
+    if (boardView.getMode() == BoardView::FOLLOW)
+    {
+        for (int i = 0; i < Robot::robotDeque.size(); i++)
+        {
+            if (Robot::robotDeque[i]->getName() == boardView.getRobotName())
+            {
+                followedX = Robot::robotDeque[i]->getPositionX();
+                followedY = Robot::robotDeque[i]->getPositionY();
+                break;
+            }
+        }
+    }
+
+    boardView.placeWindow(board.getWidth(), board.getHeight(), followedX, followedY, snapshot.viewLeft, snapshot.viewTop);
+
+    actionLog.resetLog();
+}
+
 /// @brief Updates the game display in the terminal
 /// 
-/// Reads interface.template and outputs game data to terminal following the template format.
-/// This function will also log the output to the game.log file.
+/// If the render policy displays the turn that has just been played, it is captured
+/// and displayed right away, or handed to the render thread if one has been started.
 /// 
 inline void Game::updateInterface()
 {
-    displayBuffer = "";
+    bool isFinalTurn = Robot::robotDeque.size() <= 1 || turn + 1 > turnLimit;
+    bool hadEvents = Robot::killCount != turnStartKillCount || Robot::evolveCount != turnStartEvolveCount;
 
-    board.refresh();
+    if (isHeadless || !renderPolicy.shouldDisplay(turn, isFinalTurn, hadEvents))
+    {
+        actionLog.resetLog();
+        return;
+    }
 
-    string input;
+    captureTurn(currentTurn);
 
-    // Current Game Turn
-    getline(interfaceTemplate, input, '\'');
-    displayBuffer += input;
-    displayBuffer += to_string(turn);
+    if (renderQueue != nullptr)
+    {
+        renderQueue->push(move(currentTurn));
+    }
+    else
+    {
+        render(currentTurn);
+    }
+}
 
-    // Number of robots alive
-    getline(interfaceTemplate, input, '\'');
-    displayBuffer += input;
-    displayBuffer += to_string(Robot::robotDeque.size());
+/// @brief Displays a turn in the terminal
+/// 
+/// Outputs game data to terminal following the format of interface.template.
+/// This function will also log the output to the game.log file.
+/// 
+/// @param snapshot the turn to display
+inline void Game::render(const TurnSnapshot &snapshot)
+{
+    displayBuffer.clear();
 
-    // Number of robots waiting to revive
-    getline(interfaceTemplate, input, '\'');
-    displayBuffer += input;
-    displayBuffer += to_string(Robot::reviveDeque.size());
-    
-    // Robot actions taken this turn
-    getline(interfaceTemplate, input, '\'');
-    displayBuffer += input;
+    {
+        PROFILE_SCOPE(Profiler::BOARD_REFRESH);
+
+        switch (boardView.getMode())
+        {
+        case BoardView::FULL:
+            board.refresh(snapshot.robots);
+            break;
+        case BoardView::WINDOW:
+        case BoardView::FOLLOW:
+            board.refreshWindow(snapshot.robots, snapshot.viewLeft, snapshot.viewTop,
+                                min(boardView.getWidth(), board.getWidth()), min(boardView.getHeight(), board.getHeight()));
+            break;
+        case BoardView::OVERVIEW:
+            board.refreshOverview(snapshot.robots, boardView.getWidth(), boardView.getHeight());
+            break;
+        }
+    }
+
+    const string &boardText = board.getBoard();
 
-    displayBuffer += actionLog.getLog();
+    {
+        PROFILE_SCOPE(Profiler::INTERFACE_COMPOSITION);
 
-    // Game board
-    getline(interfaceTemplate, input, '\'');
-    displayBuffer += input;
-    displayBuffer += board.getBoard() + '\n';
+        // Current Game Turn
+        displayBuffer += interfaceParts[0];
+        appendNumber(displayBuffer, snapshot.turn);
 
-    // Display to terminal
-    cout << displayBuffer;
+        // Number of robots alive
+        displayBuffer += interfaceParts[1];
+        appendNumber(displayBuffer, snapshot.aliveCount);
 
-    // Record output in log file
-    logFile << displayBuffer;
+        // Number of robots waiting to revive
+        displayBuffer += interfaceParts[2];
+        appendNumber(displayBuffer, snapshot.revivingCount);
+        
+        // Robot actions taken this turn
+        displayBuffer += interfaceParts[3];
 
-    // move the read position back to the beginning of the file
-    interfaceTemplate.seekg(0, interfaceTemplate.beg);
+        displayBuffer += snapshot.actionLog;
+        size_t actionLogEnd = displayBuffer.size();
 
-    actionLog.resetLog();
+        // Game board, which follows displayBuffer in the output
+        displayBuffer += interfaceParts[4];
+
+        if (isAnsiOutput)
+        {
+            int logRows = count(snapshot.actionLog.begin(), snapshot.actionLog.end(), '\n');
+            actionLogRows = max(actionLogRows, logRows);
+
+            terminalBuffer.assign(displayBuffer, 0, actionLogEnd);
+            terminalBuffer.append(actionLogRows - logRows, '\n');
+            terminalBuffer.append(displayBuffer, actionLogEnd, string::npos);
+            terminalBuffer += boardText;
+            terminalBuffer += '\n';
+        }
+    }
+
+    {
+        PROFILE_SCOPE(Profiler::INTERFACE_OUTPUT);
+        TRACE_SCOPE("log flush");
+
+        // the interface, the board & the line after it are written with one system call per file
+        const iovec frame[] = {
+            {(void *)displayBuffer.data(), displayBuffer.size()},
+            {(void *)boardText.data(), boardText.size()},
+            {(void *)"\n", 1}};
+
+        // anything written to cout before has to reach the terminal first
+        cout.flush();
+
+        // Display to terminal
+        if (isAnsiOutput)
+        {
+            const string &terminalOutput = terminalScreen.update(terminalBuffer, TerminalScreen::terminalHeight());
+            const iovec update = {(void *)terminalOutput.data(), terminalOutput.size()};
+
+            writeGathered(STDOUT_FILENO, &update, 1);
+        }
+        else
+        {
+            writeGathered(STDOUT_FILENO, frame, 3);
+        }
+
+        // Record output in log file
+        writeGathered(logFileDescriptor, frame, 3);
+    }
+}
+
+/// @brief Appends a number to a buffer without creating a temporary string
+/// @param buffer the buffer
+/// @param number the number
+inline void Game::appendNumber(string &buffer, long long number)
+{
+    char digits[24];
+    to_chars_result result = to_chars(digits, digits + sizeof(digits), number);
+
+    buffer.append(digits, result.ptr);
+}
+
+/// @brief Writes every part to a file in order, with as few system calls as possible.
+/// Output that can not be written (e.g. to a closed terminal) is dropped, just like
+/// it is by cout
+/// @param fileDescriptor file to write to
+/// @param parts the parts to write
+/// @param partCount number of parts, at most MAX_OUTPUT_PARTS
+inline void Game::writeGathered(int fileDescriptor, const iovec *parts, int partCount)
+{
+    iovec pending[MAX_OUTPUT_PARTS];
+    int pendingCount = min(partCount, MAX_OUTPUT_PARTS);
+    copy(parts, parts + pendingCount, pending);
+
+    iovec *next = pending;
+
+    while (pendingCount > 0)
+    {
+        ssize_t written = writev(fileDescriptor, next, pendingCount);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return;
+        }
+
+        // skip the parts that have been written completely, and the written start of the next one
+        while (pendingCount > 0 && (size_t)written >= next->iov_len)
+        {
+            written -= next->iov_len;
+            next++;
+            pendingCount--;
+        }
+
+        if (pendingCount > 0)
+        {
+            next->iov_base = (char *)next->iov_base + written;
+            next->iov_len -= written;
+        }
+    }
+}
+
+inline void Game::setRenderPolicy(const RenderPolicy &policy)
+{
+    renderPolicy = policy;
+}
+
+/// @details Must not be called while a render thread is running
+inline void Game::setBoardView(const BoardView &view)
+{
+    boardView = view;
+}
+
+/// @details Must not be called while a render thread is running
+inline void Game::setAnsiOutput(bool isAnsiOutput)
+{
+    this->isAnsiOutput = isAnsiOutput;
+    terminalScreen.reset();
+    actionLogRows = 0;
+}
+
+inline void Game::setSimultaneousTurns(bool isSimultaneous, int threadCount)
+{
+    this->isSimultaneous = isSimultaneous;
+    simultaneousTurn.setThreadCount(threadCount > 0 ? threadCount : (int)thread::hardware_concurrency());
+}
+
+inline void Game::setTargetedFire(bool isTargetedFire)
+{
+    this->isTargetedFire = isTargetedFire;
+    Robot::isTargetedFire = isTargetedFire;
+
+    // the index is built at the start of every turn while it is needed
+    if (!isTargetedFire && !isHunting && Robot::occupiedCells == &occupiedCells)
+    {
+        Robot::occupiedCells = nullptr;
+    }
+}
+
+inline void Game::setHunting(bool isHunting)
+{
+    this->isHunting = isHunting;
+    Robot::isHunting = isHunting;
+
+    if (!isTargetedFire && !isHunting && Robot::occupiedCells == &occupiedCells)
+    {
+        Robot::occupiedCells = nullptr;
+    }
+}
+
+/// @brief Indexes the cells every robot stands on at the start of a turn. During a
+/// turn that is not simultaneous, moves & kills keep the index up to date
+inline void Game::indexOccupiedCells()
+{
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    occupiedCells.reset(Board::getWidth(), Board::getHeight(), robots.size());
+
+    for (int i = 0; i < robots.size(); i++)
+    {
+        occupiedCells.insert(robots[i]->getPositionX(), robots[i]->getPositionY(), robots[i]->getId());
+    }
+
+    Robot::occupiedCells = &occupiedCells;
+}
+
+/// @brief Marks the cell every robot stands on at the start of a turn, on boards small
+/// enough to keep a bitboard of. During a turn that is not simultaneous, moves mark the
+/// cells robots move onto
+inline void Game::markOccupiedCells()
+{
+    if ((long long)Board::getWidth() * Board::getHeight() > MAX_BITBOARD_CELLS)
+    {
+        Robot::occupiedBits = nullptr;
+        return;
+    }
+
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    occupiedBits.reset(Board::getWidth(), Board::getHeight());
+
+    for (int i = 0; i < robots.size(); i++)
+    {
+        occupiedBits.set(robots[i]->getPositionX(), robots[i]->getPositionY());
+    }
+
+    Robot::occupiedBits = &occupiedBits;
+}
+
+/// @details Turns are played as fast as the render thread can display them, with
+/// at most queueCapacity played turns waiting to be displayed
+inline void Game::startRenderThread(int queueCapacity)
+{
+    if (isHeadless || renderQueue != nullptr)
+    {
+        return;
+    }
+
+    renderQueue = make_unique<SnapshotQueue<TurnSnapshot>>(queueCapacity);
+
+    renderThread = thread([this, width = board.getWidth(), height = board.getHeight()] {
+        Board::setSize(width, height);
+
+        TurnSnapshot snapshot;
+
+        while (renderQueue->pop(snapshot))
+        {
+            render(snapshot);
+        }
+    });
+}
+
+inline void Game::stopRenderThread()
+{
+    if (renderQueue == nullptr)
+    {
+        return;
+    }
+
+    renderQueue->close();
+    renderThread.join();
+    renderQueue.reset();
 }
 
 /// @brief Revives the robot in front of the reviveDeque and places it in a
 /// random position on the board
 inline void Game::revive()
 {
+    TRACE_SCOPE("Game::revive", Tracer::robotArgs(Robot::reviveDeque.front()->getName(), Robot::reviveDeque.front()->getType()));
+
     Robot::reviveDeque.front()->setNextTurn(turn);
 
-    int robotCount = Robot::robotDeque.size();
-    
-    
-    // listing all invalid board positions in arrays for easy access
-    int invalidXPositions[robotCount];
-    int invalidYPositions[robotCount];
+    RNG::selectStream(turn, RNG::REVIVE_STREAM);
 
-    for (int i=0; i < robotCount; i++) {
-        invalidXPositions[i] = Robot::robotDeque[i]->getPositionX();
-        invalidYPositions[i] = Robot::robotDeque[i]->getPositionY();
-    }
+    // Generating a valid revive position
+    int reviveXPosition = 0;
+    int reviveYPosition = 0;
 
+    if (Robot::occupiedBits != nullptr)
+    {
+        // The bitboard was rebuilt at the start of the turn, so its free cells are exactly
+        // the cells no robot stands on
+        long long freeCells = occupiedBits.countClear();
 
-    // Generating a valid revive position
-    bool isValidRevivePosition = false;
-    int reviveXPosition;
-    int reviveYPosition;
+        // With every cell taken, the robot waits for a cell to become free
+        if (freeCells == 0)
+        {
+            return;
+        }
+
+        if (freeCells * 64 < (long long)Board::getWidth() * Board::getHeight())
+        {
+            // On an almost full board, the free cell is picked directly rather than by
+            // drawing cells until a free one comes up
+            occupiedBits.findNthClear(RNG::integer(0, freeCells - 1), reviveXPosition, reviveYPosition);
+        }
+        else
+        {
+            do
+            {
+                reviveXPosition = RNG::posX();
+                reviveYPosition = RNG::posY();
+            } while (occupiedBits.test(reviveXPosition, reviveYPosition));
+        }
 
-    while (!isValidRevivePosition)
+        occupiedBits.set(reviveXPosition, reviveYPosition);
+    }
+    else
     {
-        reviveXPosition = RNG::posX();
-        reviveYPosition = RNG::posY();
+        int robotCount = Robot::robotDeque.size();
 
-        isValidRevivePosition = true;
+        // listing all invalid board positions in arrays for easy access
+        vector<int> invalidXPositions(robotCount);
+        vector<int> invalidYPositions(robotCount);
 
-        // checking if the generated position matches any of the invalid positions
         for (int i=0; i < robotCount; i++) {
-            if (reviveXPosition == invalidXPositions[i] && reviveYPosition == invalidYPositions[i]) {
-                isValidRevivePosition = false;
-                break;
+            invalidXPositions[i] = Robot::robotDeque[i]->getPositionX();
+            invalidYPositions[i] = Robot::robotDeque[i]->getPositionY();
+        }
+
+        bool isValidRevivePosition = false;
+
+        while (!isValidRevivePosition)
+        {
+            reviveXPosition = RNG::posX();
+            reviveYPosition = RNG::posY();
+
+            isValidRevivePosition = true;
+
+            // checking if the generated position matches any of the invalid positions
+            for (int i=0; i < robotCount; i++) {
+                if (reviveXPosition == invalidXPositions[i] && reviveYPosition == invalidYPositions[i]) {
+                    isValidRevivePosition = false;
+                    break;
+                }
             }
         }
     }
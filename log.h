@@ -16,8 +16,8 @@ class Log
 {
 private:
     /// @brief string that temporarily stores all robot action log messages
-    /// before they are outputted to the terminal
-    static string logBuffer;
+    /// before they are outputted to the terminal. Every thread has its own
+    static thread_local string logBuffer;
 
     /*---------------------------------------------*/
     /*         Action Log Message Template         */
@@ -35,7 +35,7 @@ private:
     static void inputAtNextPosition(istringstream &inputStream, int input);
 
 public:
-    string getLog() const;
+    const string &getLog() const;
 
     void resetLog();
 
@@ -48,7 +48,7 @@ public:
     static void revive(string robotName, int posX, int posY);
 };
 
-string Log::logBuffer = "";
+thread_local string Log::logBuffer = "";
 
 /*---------------------------------------------*/
 /*         Action Log Message Template         */
@@ -92,7 +92,7 @@ inline void Log::inputAtNextPosition(istringstream &inputStream, int input)
     getline(inputStream, temp, '}');
 }
 
-inline string Log::getLog() const
+inline const string &Log::getLog() const
 {
     return logBuffer;
 }
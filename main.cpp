@@ -7,39 +7,240 @@
  * After that, the main game loop starts and only ends when the game has reached an invalid
  * state (either there is only one robot left OR the game has reached the turn counter limit)
  *
+ * Running the program with --checkpoint-every N saves the game to game.checkpoint every
+ * N turns. Entering that file instead of a config file resumes the game from the turn it
+ * was saved at.
+ *
+ * Running the program with --pipelined displays the game on a separate render
+ * thread and plays every turn without waiting for enter to be pressed, so the
+ * next turn is played while the previous one is being displayed.
+ *
+ * Long games can display fewer turns (the final turn is always displayed):
+ *   --every N            display every Nth turn
+ *   --fps K              display at most K turns per second
+ *   --on-events          display only turns in which a robot was killed or evolved
+ *   --final-only         display only the final turn
+ * With any of these, the game does not wait for enter between turns either.
+ *
+ * Boards larger than the terminal can be displayed in part:
+ *   --window X Y W H     display the W x H window with its top left corner at X, Y
+ *   --follow NAME W H    display a W x H window centered on the robot NAME
+ *   --overview W H       display the whole board shrunk down to W x H characters,
+ *                        each showing the number of robots in its block of cells
+ *
+ * Running the program with --simultaneous plays every turn with the simultaneous
+ * rules (see simultaneous.h), where all robots decide their actions at the same
+ * time on one thread per core, or on N threads with --threads N.
+ *
+ * Running the program with --targeted-fire lets RoboCops & TerminatorRoboCops
+ * fire at the robots within their fire range instead of at random cells in it.
+ * Running it with --hunting lets Terminators & TerminatorRoboCops that see no
+ * robot next to them step toward the nearest robot instead of at random.
+ *
+ * Running the program with --ansi redraws the interface in place on an ANSI
+ * terminal, writing only the characters that changed since the last turn.
+ *
+ * Random numbers:
+ *   --seed S             seed the random number generator, so the game can be replayed
+ *   --streams ID         draw every robot's random numbers from its own counter-based
+ *                        stream (see random.h), keyed on the seed, the game id ID, the
+ *                        turn and the robot, so they do not depend on the order robots
+ *                        are run in
+ *
  */
 
 #include <iostream>
-#include <fstream>
+#include <random>
 
 #include "interface.h"
 
 using namespace std;
 
-int main()   
+const string CHECKPOINT_FILENAME = "game.checkpoint";
+
+int main(int argc, char *argv[])
 {
-    ifstream configFile;
     string filename;
+    bool isPipelined = false;
+    bool isAnsiOutput = false;
+    bool isSimultaneous = false;
+    int threadCount = 0;
+    bool isTargetedFire = false;
+    bool isHunting = false;
+    int checkpointInterval = 0;
+    bool isSeeded = false;
+    unsigned int seed = 0;
+    bool isUsingStreams = false;
+    unsigned int gameId = 0;
+    RenderPolicy renderPolicy;
+    BoardView boardView;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+
+        try
+        {
+            if (option == "--pipelined")
+                isPipelined = true;
+            else if (option == "--ansi")
+                isAnsiOutput = true;
+            else if (option == "--simultaneous")
+                isSimultaneous = true;
+            else if (option == "--targeted-fire")
+                isTargetedFire = true;
+            else if (option == "--hunting")
+                isHunting = true;
+            else if (option == "--threads" && i + 1 < argc)
+            {
+                threadCount = stoi(argv[++i]);
+
+                if (threadCount < 1)
+                    throw invalid_argument(option);
+            }
+            else if (option == "--checkpoint-every" && i + 1 < argc)
+            {
+                checkpointInterval = stoi(argv[++i]);
+
+                if (checkpointInterval < 1)
+                    throw invalid_argument(option);
+            }
+            else if (option == "--seed" && i + 1 < argc)
+            {
+                seed = stoul(argv[++i]);
+                isSeeded = true;
+            }
+            else if (option == "--streams" && i + 1 < argc)
+            {
+                gameId = stoul(argv[++i]);
+                isUsingStreams = true;
+            }
+            else if (option == "--every" && i + 1 < argc)
+                renderPolicy = RenderPolicy::everyNTurns(stoi(argv[++i]));
+            else if (option == "--fps" && i + 1 < argc)
+                renderPolicy = RenderPolicy::frameRate(stod(argv[++i]));
+            else if (option == "--on-events")
+                renderPolicy = RenderPolicy::onEvents();
+            else if (option == "--final-only")
+                renderPolicy = RenderPolicy::finalOnly();
+            else if (option == "--window" && i + 4 < argc)
+            {
+                boardView = BoardView::window(stoi(argv[i + 1]), stoi(argv[i + 2]), stoi(argv[i + 3]), stoi(argv[i + 4]));
+                i += 4;
+            }
+            else if (option == "--follow" && i + 3 < argc)
+            {
+                boardView = BoardView::follow(argv[i + 1], stoi(argv[i + 2]), stoi(argv[i + 3]));
+                i += 3;
+            }
+            else if (option == "--overview" && i + 2 < argc)
+            {
+                boardView = BoardView::overview(stoi(argv[i + 1]), stoi(argv[i + 2]));
+                i += 2;
+            }
+            else
+            {
+                cout << "[ERROR] Unknown option " << option << endl;
+                cout << "[EXIT] Exiting..." << endl;
+                return 0;
+            }
+        }
+        catch (const logic_error &)
+        { // Error output when an option value is not a valid number
+            cout << "[ERROR] Invalid value for option " << option << endl;
+            cout << "[EXIT] Exiting..." << endl;
+            return 0;
+        }
+        catch (RenderPolicy::InvalidParameter)
+        { // Error output when the value of --every or --fps is not positive
+            cout << "[ERROR] Invalid value for option " << option << endl;
+            cout << "[EXIT] Exiting..." << endl;
+            return 0;
+        }
+        catch (BoardView::InvalidParameter)
+        { // Error output when the size or position of a board view is invalid
+            cout << "[ERROR] Invalid value for option " << option << endl;
+            cout << "[EXIT] Exiting..." << endl;
+            return 0;
+        }
+    }
+
+    // Turns are only stepped through one at a time when every turn is displayed
+    bool isStepping = !isPipelined && renderPolicy.getMode() == RenderPolicy::EVERY_TURN;
 
     cout << "Please enter the name of the initial game configuration file:" << endl;
     cin >> filename;
 
-    configFile.open(filename);
-    if (!configFile.is_open())
+    if (isUsingStreams)
+    {
+        RNG::seedStreams(isSeeded ? seed : random_device{}(), gameId);
+    }
+    else if (isSeeded)
+    {
+        RNG::seed(seed);
+    }
+
+    try
+    {
+        // Read in data from config file
+        Game game(filename);
+        game.setRenderPolicy(renderPolicy);
+        game.setBoardView(boardView);
+        game.setAnsiOutput(isAnsiOutput);
+        game.setSimultaneousTurns(isSimultaneous, threadCount);
+        game.setTargetedFire(isTargetedFire);
+        game.setHunting(isHunting);
+
+        if (isPipelined)
+        {
+            game.startRenderThread();
+        }
+
+        // main game loop
+        while (game.isValidState()) {
+            game.nextTurn();
+
+            if (checkpointInterval > 0 && game.getTurn() % checkpointInterval == 0)
+            {
+                game.saveCheckpoint(CHECKPOINT_FILENAME);
+            }
+
+            if (isStepping)
+            {
+                cout << "Press enter to continue..." << endl;
+                cin.get();
+            }
+        }
+    }
+    catch (MappedFile::OpeningError)
     { // Error output when the config file could not be opened
         cout << "[ERROR] Error opening initial game configuration file" << endl;
         cout << "[EXIT] Exiting..." << endl;
         return 0;
     }
-
-    // Read in data from config file
-    Game game(configFile);
-
-    // main game loop
-    while (game.isValidState()) {
-        game.nextTurn();
-        cout << "Press enter to continue..." << endl;
-        cin.get();
+    catch (const ConfigParser::ConfigError &error)
+    { // Error output when the config file contains an error
+        cout << "[ERROR] " << filename << ":" << error.line << ":" << error.column << ": " << error.message << endl;
+        cout << "[EXIT] Exiting..." << endl;
+        return 0;
+    }
+    catch (Scenario::InvalidScenario)
+    { // Error output when the binary scenario file is damaged
+        cout << "[ERROR] The binary scenario file is invalid" << endl;
+        cout << "[EXIT] Exiting..." << endl;
+        return 0;
+    }
+    catch (GameState::InvalidCheckpoint)
+    { // Error output when the checkpoint file is damaged
+        cout << "[ERROR] The checkpoint file is invalid" << endl;
+        cout << "[EXIT] Exiting..." << endl;
+        return 0;
+    }
+    catch (Game::CheckpointSavingError)
+    { // Error output when the game could not be saved
+        cout << "[ERROR] Error saving checkpoint file " << CHECKPOINT_FILENAME << endl;
+        cout << "[EXIT] Exiting..." << endl;
+        return 0;
     }
 
     cout << "\nGAME OVER!\n";
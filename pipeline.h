@@ -0,0 +1,129 @@
+/*
+ *
+ * This file contains the classes that pass finished turns from the thread
+ * playing the game to the thread displaying it
+ *
+ * --- Code Summary ---
+ * After a turn has been played, everything the interface shows for it (the
+ * turn number, robot counts, action log, the robots on the board & the part
+ * of the board that is shown) is copied
+ * into a TurnSnapshot. A snapshot is never changed after it has been captured,
+ * so the render thread can draw and write it out while the game thread is
+ * already playing the next turn.
+ *
+ * Snapshots are handed over through a SnapshotQueue, a bounded queue guarded
+ * by a mutex. push() waits while the queue is full, so the game never runs
+ * more than a few turns ahead of the display, and pop() waits while it is
+ * empty. Once the queue is closed, pop() returns the snapshots that are left
+ * and then reports that there are no more.
+ *
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "deque.h"
+
+using namespace std;
+
+/// @brief Everything the interface shows for one turn
+struct TurnSnapshot
+{
+    int turn = 0;
+    int aliveCount = 0;
+    int revivingCount = 0;
+    string actionLog;
+
+    /// @brief robots on the board, in robotDeque order
+    vector<BoardRobot> robots;
+
+    /// @brief position of the window shown when the board view is a window
+    int viewLeft = 0;
+    int viewTop = 0;
+};
+
+template <typename T>
+class SnapshotQueue
+{
+private:
+    Deque<T> items;
+    int capacity;
+    bool isClosed = false;
+
+    mutex queueMutex;
+    condition_variable notFull;
+    condition_variable notEmpty;
+
+public:
+    /// @param capacity maximum number of items waiting in the queue
+    SnapshotQueue(int capacity);
+
+    /// @brief Adds an item to the back of the queue, waiting while the queue is full
+    /// @param item the item
+    void push(T item);
+
+    /// @brief Takes the item at the front of the queue, waiting while the queue is empty
+    /// @param item the item that is taken
+    /// @return true if an item was taken, false if the queue is closed and empty
+    bool pop(T &item);
+
+    /// @brief Marks that no more items will be pushed
+    void close();
+};
+
+template <typename T>
+inline SnapshotQueue<T>::SnapshotQueue(int capacity)
+{
+    this->capacity = capacity;
+    items.reserve(capacity);
+}
+
+template <typename T>
+inline void SnapshotQueue<T>::push(T item)
+{
+    unique_lock<mutex> lock(queueMutex);
+    notFull.wait(lock, [this] { return items.size() < capacity; });
+
+    items.push_back(std::move(item));
+
+    lock.unlock();
+    notEmpty.notify_one();
+}
+
+template <typename T>
+inline bool SnapshotQueue<T>::pop(T &item)
+{
+    unique_lock<mutex> lock(queueMutex);
+    notEmpty.wait(lock, [this] { return !items.is_empty() || isClosed; });
+
+    if (items.is_empty())
+    {
+        return false;
+    }
+
+    item = items.pop_front();
+
+    lock.unlock();
+    notFull.notify_one();
+
+    return true;
+}
+
+template <typename T>
+inline void SnapshotQueue<T>::close()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        isClosed = true;
+    }
+
+    notEmpty.notify_all();
+}
+
+#endif
@@ -0,0 +1,384 @@
+/*
+ *
+ * This file contains the Profiler class that measures how long each phase of
+ * a game turn takes
+ *
+ * --- Code Summary ---
+ * The time taken by every phase (reviving, each robot type's executeTurn,
+ * refreshing the board, composing the interface, writing it out, recording
+ * the replay & playing a simultaneous turn) is recorded
+ * into a Histogram. Histograms use buckets that grow exponentially in size with
+ * 8 linear sub-buckets each, so recording a time is a few integer operations and
+ * every percentile is accurate to within 12.5%. At the end of a game the
+ * p50/p90/p99/max of every phase is printed.
+ *
+ * Phases may be recorded from several threads at once (the render thread, or
+ * the workers of a BatchRunner each playing a game). Every thread records into
+ * its own histograms, which are only merged when the profile is printed.
+ *
+ * Profiling is only compiled in when PROFILE_TURNS is defined
+ * (g++ -DPROFILE_TURNS ...). Otherwise the PROFILE_* macros expand to nothing
+ * and none of the code below is compiled.
+ *
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#ifdef PROFILE_TURNS
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "robot.h"
+
+using namespace std;
+
+class Histogram
+{
+private:
+    /// @brief Every power of two range is split into 2^SUB_BUCKET_BITS buckets
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = 64 * SUB_BUCKETS;
+
+    uint64_t counts[BUCKET_COUNT] = {};
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(int index);
+
+public:
+    void record(uint64_t value);
+    void reset();
+
+    /// @brief Adds every value recorded into another histogram to this one
+    void merge(const Histogram &other);
+
+    uint64_t getCount() const;
+    uint64_t getMax() const;
+    double getMean() const;
+
+    /// @param fraction fraction of values that should be less than or equal to the result, e.g. 0.99
+    /// @return the value at the given percentile, rounded up to the end of its bucket
+    uint64_t percentile(double fraction) const;
+};
+
+inline int Histogram::bucketIndex(uint64_t value)
+{
+    // values below SUB_BUCKETS get a bucket each
+    if (value < SUB_BUCKETS)
+    {
+        return (int)value;
+    }
+
+    int highestBit = 63 - __builtin_clzll(value);
+    int shift = highestBit - SUB_BUCKET_BITS;
+    int subBucket = (int)(value >> shift) & (SUB_BUCKETS - 1);
+
+    return ((shift + 1) << SUB_BUCKET_BITS) + subBucket;
+}
+
+inline uint64_t Histogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+    {
+        return index;
+    }
+
+    int shift = (index >> SUB_BUCKET_BITS) - 1;
+    uint64_t lowerBound = (uint64_t)(SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift;
+
+    return lowerBound + ((uint64_t)1 << shift) - 1;
+}
+
+inline void Histogram::record(uint64_t value)
+{
+    counts[bucketIndex(value)]++;
+    count++;
+    total += value;
+
+    if (value > maximum)
+    {
+        maximum = value;
+    }
+}
+
+inline void Histogram::reset()
+{
+    *this = Histogram();
+}
+
+inline void Histogram::merge(const Histogram &other)
+{
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        counts[i] += other.counts[i];
+    }
+
+    count += other.count;
+    total += other.total;
+    maximum = max(maximum, other.maximum);
+}
+
+inline uint64_t Histogram::getCount() const
+{
+    return count;
+}
+
+inline uint64_t Histogram::getMax() const
+{
+    return maximum;
+}
+
+inline double Histogram::getMean() const
+{
+    return count == 0 ? 0 : (double)total / count;
+}
+
+inline uint64_t Histogram::percentile(double fraction) const
+{
+    uint64_t target = (uint64_t)(fraction * count + 0.5);
+    if (target == 0)
+    {
+        target = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += counts[i];
+
+        if (seen >= target)
+        {
+            return min(bucketUpperBound(i), maximum);
+        }
+    }
+
+    return maximum;
+}
+
+class Profiler
+{
+public:
+    /// @brief Every phase of a turn that is timed. The executeTurn phases
+    /// are in the same order as RobotType
+    enum Phase
+    {
+        TURN,
+        REVIVE,
+        EXECUTE_ROBOCOP,
+        EXECUTE_TERMINATOR,
+        EXECUTE_TERMINATOR_ROBOCOP,
+        EXECUTE_BLUE_THUNDER,
+        EXECUTE_MADBOT,
+        EXECUTE_ROBOTANK,
+        EXECUTE_ULTIMATE_ROBOT,
+        EXECUTE_NEMESIS,
+        BOARD_REFRESH,
+        INTERFACE_COMPOSITION,
+        INTERFACE_OUTPUT,
+        REPLAY_RECORDING,
+        SIMULTANEOUS_TURN,
+        PHASE_COUNT
+    };
+
+private:
+    /// @brief The histograms of one thread. The lock is only contended while
+    /// the profile is being printed
+    struct ThreadHistograms
+    {
+        Histogram histograms[PHASE_COUNT];
+        mutex histogramsMutex;
+
+        ThreadHistograms();
+        ~ThreadHistograms();
+    };
+
+    static thread_local ThreadHistograms threadHistograms;
+
+    /// @brief histograms of every thread that has recorded a phase & is still running
+    static vector<ThreadHistograms *> threads;
+
+    /// @brief histograms of the threads that have ended since the profile was last printed
+    static Histogram endedThreads[PHASE_COUNT];
+    static mutex threadsMutex;
+
+    static const char *const PHASE_NAMES[PHASE_COUNT];
+
+public:
+    /// @brief Records the time taken by one run of a phase into the calling thread's histograms
+    /// @param phase the phase
+    /// @param nanoseconds time taken
+    static void record(Phase phase, uint64_t nanoseconds);
+
+    /// @param robotTypeName type of the robot, as returned by Robot::getType()
+    /// @return the executeTurn phase of the given robot type
+    static Phase executeTurnPhase(const string &robotTypeName);
+
+    /// @brief Prints the p50/p90/p99/max of every phase, recorded on any thread, & clears all histograms
+    /// @param output stream to print to
+    static void report(ostream &output);
+};
+
+thread_local Profiler::ThreadHistograms Profiler::threadHistograms;
+vector<Profiler::ThreadHistograms *> Profiler::threads;
+Histogram Profiler::endedThreads[Profiler::PHASE_COUNT];
+mutex Profiler::threadsMutex;
+
+const char *const Profiler::PHASE_NAMES[Profiler::PHASE_COUNT] = {
+    "turn (total)",
+    "revive",
+    "executeTurn RoboCop",
+    "executeTurn Terminator",
+    "executeTurn TerminatorRoboCop",
+    "executeTurn BlueThunder",
+    "executeTurn Madbot",
+    "executeTurn RoboTank",
+    "executeTurn UltimateRobot",
+    "executeTurn Nemesis",
+    "board refresh",
+    "interface composition",
+    "interface output",
+    "replay recording",
+    "simultaneous turn",
+};
+
+inline Profiler::ThreadHistograms::ThreadHistograms()
+{
+    lock_guard<mutex> lock(threadsMutex);
+    threads.push_back(this);
+}
+
+inline Profiler::ThreadHistograms::~ThreadHistograms()
+{
+    // what the thread recorded is kept until the profile is printed
+    lock_guard<mutex> lock(threadsMutex);
+
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        endedThreads[i].merge(histograms[i]);
+    }
+
+    threads.erase(find(threads.begin(), threads.end(), this));
+}
+
+inline void Profiler::record(Phase phase, uint64_t nanoseconds)
+{
+    ThreadHistograms &local = threadHistograms;
+
+    lock_guard<mutex> lock(local.histogramsMutex);
+    local.histograms[phase].record(nanoseconds);
+}
+
+inline Profiler::Phase Profiler::executeTurnPhase(const string &robotTypeName)
+{
+    RobotType type = robotTypeFromName(robotTypeName);
+
+    return type == INVALID_ROBOT_TYPE ? TURN : (Phase)(EXECUTE_ROBOCOP + type);
+}
+
+inline void Profiler::report(ostream &output)
+{
+    // merge the histograms of every thread, clearing them for the next game
+    Histogram histograms[PHASE_COUNT];
+
+    {
+        lock_guard<mutex> lock(threadsMutex);
+
+        for (int i = 0; i < PHASE_COUNT; i++)
+        {
+            histograms[i].merge(endedThreads[i]);
+            endedThreads[i].reset();
+        }
+
+        for (ThreadHistograms *thread : threads)
+        {
+            lock_guard<mutex> threadLock(thread->histogramsMutex);
+
+            for (int i = 0; i < PHASE_COUNT; i++)
+            {
+                histograms[i].merge(thread->histograms[i]);
+                thread->histograms[i].reset();
+            }
+        }
+    }
+
+    ios::fmtflags outputFlags = output.flags();
+    streamsize outputPrecision = output.precision();
+
+    output << "\n[Turn Profile] (microseconds)\n";
+    output << left << setw(32) << "phase" << right
+           << setw(10) << "count" << setw(12) << "mean" << setw(12) << "p50"
+           << setw(12) << "p90" << setw(12) << "p99" << setw(12) << "max" << '\n';
+
+    output << fixed << setprecision(2);
+
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        const Histogram &histogram = histograms[i];
+
+        if (histogram.getCount() == 0)
+        {
+            continue;
+        }
+
+        output << left << setw(32) << PHASE_NAMES[i] << right
+               << setw(10) << histogram.getCount()
+               << setw(12) << histogram.getMean() / 1000
+               << setw(12) << histogram.percentile(0.50) / 1000.0
+               << setw(12) << histogram.percentile(0.90) / 1000.0
+               << setw(12) << histogram.percentile(0.99) / 1000.0
+               << setw(12) << histogram.getMax() / 1000.0 << '\n';
+    }
+
+    output.flags(outputFlags);
+    output.precision(outputPrecision);
+}
+
+/// @brief Records the time between its construction and destruction into a phase
+class PhaseTimer
+{
+private:
+    Profiler::Phase phase;
+    chrono::steady_clock::time_point start;
+
+public:
+    PhaseTimer(Profiler::Phase phase)
+    {
+        this->phase = phase;
+        start = chrono::steady_clock::now();
+    }
+
+    ~PhaseTimer()
+    {
+        auto elapsed = chrono::steady_clock::now() - start;
+        Profiler::record(phase, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+/// @brief Times the rest of the enclosing scope as the given phase
+#define PROFILE_SCOPE(phase) PhaseTimer PROFILE_CONCAT(phaseTimer, __LINE__)(phase)
+
+/// @brief Prints the profile of the game that has ended
+#define PROFILE_REPORT(output) Profiler::report(output)
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_REPORT(output)
+
+#endif
+
+#endif
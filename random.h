@@ -11,39 +11,359 @@
  * is accessible from any scope without needing to instantiate an object
  * of class RNG.
  *
+ * By default every random number comes from one mt19937, so the numbers a
+ * robot gets depend on every number drawn before them. seedStreams() switches
+ * to counter-based streams instead: every number is computed (with Philox,
+ * see PhiloxStream) from the seed, the game id, the turn, the id of the robot
+ * drawing it and how many numbers that robot has drawn this turn. The game
+ * selects the stream of each robot before it acts (selectStream()), so a robot
+ * gets the same numbers no matter which thread runs it, what was drawn before
+ * it or where it stands in the robot queue. Simultaneous turns draw from the
+ * same streams (see TurnStreams), so the turn mode does not change them either.
+ *
+ * Robots that fire anywhere on the board pick all the cells they fire at in
+ * one call to cells(), which maps a batch of random words onto the board with
+ * Lemire's multiply & shift instead of a distribution per coordinate.
+ *
  */
 
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include <algorithm>
+#include <cstdint>
 #include <random>
+#include <sstream>
+#include <vector>
 using namespace std;
 
+/// @brief Counter-based random number generator (Philox4x32-10). The numbers are a
+/// function of a 64 bit key and a 128 bit counter, so any stream of numbers can be
+/// started at any point without generating the numbers before it
+class PhiloxStream
+{
+private:
+    uint32_t key[2] = {0, 0};
+    uint32_t counter[4] = {0, 0, 0, 0};
+
+    /// @brief numbers generated from the current counter, and how many of them have been used
+    uint32_t block[4];
+    int usedCount = 4;
+
+    static void philoxBlock(const uint32_t key[2], const uint32_t counter[4], uint32_t output[4]);
+    void generateBlock();
+
+public:
+    using result_type = uint32_t;
+
+    /// @brief Starts the stream of numbers identified by a key & the first 3 words of the counter
+    void select(uint64_t key, uint32_t word1, uint32_t word2, uint32_t word3);
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return UINT32_MAX;
+    }
+
+    result_type operator()();
+
+    /// @brief Generates the next count numbers of the stream at once
+    void fill(uint32_t *words, int count);
+};
+
+/// @details The 4th word of the counter numbers the blocks of 4 numbers within a stream
+inline void PhiloxStream::select(uint64_t key, uint32_t word1, uint32_t word2, uint32_t word3)
+{
+    this->key[0] = (uint32_t)key;
+    this->key[1] = (uint32_t)(key >> 32);
+
+    counter[0] = word1;
+    counter[1] = word2;
+    counter[2] = word3;
+    counter[3] = 0;
+
+    usedCount = 4;
+}
+
+/// @brief Computes the 4 numbers of one block from a key & a counter
+inline void PhiloxStream::philoxBlock(const uint32_t key[2], const uint32_t counter[4], uint32_t output[4])
+{
+    uint32_t words[4] = {counter[0], counter[1], counter[2], counter[3]};
+    uint32_t roundKey[2] = {key[0], key[1]};
+
+    for (int round = 0; round < 10; round++)
+    {
+        uint64_t product0 = (uint64_t)0xD2511F53 * words[0];
+        uint64_t product1 = (uint64_t)0xCD9E8D57 * words[2];
+
+        uint32_t mixed[4] = {
+            (uint32_t)(product1 >> 32) ^ words[1] ^ roundKey[0],
+            (uint32_t)product1,
+            (uint32_t)(product0 >> 32) ^ words[3] ^ roundKey[1],
+            (uint32_t)product0,
+        };
+
+        for (int i = 0; i < 4; i++)
+        {
+            words[i] = mixed[i];
+        }
+
+        roundKey[0] += 0x9E3779B9;
+        roundKey[1] += 0xBB67AE85;
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        output[i] = words[i];
+    }
+}
+
+inline void PhiloxStream::generateBlock()
+{
+    philoxBlock(key, counter, block);
+
+    counter[3]++;
+    usedCount = 0;
+}
+
+/// @details Whole blocks are computed straight into words. They do not depend on
+/// each other, unlike the states of most generators
+inline void PhiloxStream::fill(uint32_t *words, int count)
+{
+    int filled = 0;
+
+    // numbers left over from the current block come first
+    while (filled < count && usedCount < 4)
+    {
+        words[filled++] = block[usedCount++];
+    }
+
+    for (; count - filled >= 4; filled += 4)
+    {
+        philoxBlock(key, counter, words + filled);
+        counter[3]++;
+    }
+
+    while (filled < count)
+    {
+        words[filled++] = (*this)();
+    }
+}
+
+inline PhiloxStream::result_type PhiloxStream::operator()()
+{
+    if (usedCount == 4)
+    {
+        generateBlock();
+    }
+
+    return block[usedCount++];
+}
+
+/// @brief Draws count 32 bit random words from a generator
+template <typename Generator>
+inline void fillWords(Generator &generator, uint32_t *words, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        words[i] = (uint32_t)generator();
+    }
+}
+
+inline void fillWords(PhiloxStream &stream, uint32_t *words, int count)
+{
+    stream.fill(words, count);
+}
+
+/// @brief Maps a random word onto [0, range) with Lemire's multiply & shift, drawing
+/// new words while the word is one of the few that would make the result biased
+template <typename Generator>
+inline int boundedWord(Generator &generator, uint32_t word, uint32_t range)
+{
+    uint64_t product = (uint64_t)word * range;
+
+    // only words whose product has a low half below range can be biased, so the
+    // division is only needed for those
+    if ((uint32_t)product < range)
+    {
+        uint32_t threshold = -range % range;
+
+        while ((uint32_t)product < threshold)
+        {
+            product = (uint64_t)(uint32_t)generator() * range;
+        }
+    }
+
+    return product >> 32;
+}
+
+/// @brief Picks count cells uniformly at random on a width x height board
+/// @details The words of a chunk of cells are drawn at once and mapped onto the board
+/// in a loop without branches, instead of setting up a distribution for every
+/// coordinate. The few cells where a word might bias its coordinate are fixed up afterwards
+/// @param cellX, cellY arrays of count coordinates to fill
+template <typename Generator>
+inline void randomCells(Generator &generator, int width, int height, int count, int *cellX, int *cellY)
+{
+    static const int CHUNK_SIZE = 64;
+    uint32_t words[2 * CHUNK_SIZE];
+
+    for (int first = 0; first < count; first += CHUNK_SIZE)
+    {
+        int chunkCount = min(CHUNK_SIZE, count - first);
+        fillWords(generator, words, 2 * chunkCount);
+
+        bool isBiased = false;
+
+        for (int i = 0; i < chunkCount; i++)
+        {
+            uint64_t productX = (uint64_t)words[2 * i] * (uint32_t)width;
+            uint64_t productY = (uint64_t)words[2 * i + 1] * (uint32_t)height;
+
+            cellX[first + i] = productX >> 32;
+            cellY[first + i] = productY >> 32;
+
+            isBiased |= ((uint32_t)productX < (uint32_t)width) | ((uint32_t)productY < (uint32_t)height);
+        }
+
+        if (!isBiased)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < chunkCount; i++)
+        {
+            cellX[first + i] = boundedWord(generator, words[2 * i], width);
+            cellY[first + i] = boundedWord(generator, words[2 * i + 1], height);
+        }
+    }
+}
+
+/// @brief Identifies the random number streams of the robots in one turn
+struct TurnStreams
+{
+    uint64_t key = 0;
+    uint32_t gameId = 0;
+    uint32_t turn = 0;
+
+    /// @brief Starts the stream of one robot in this turn
+    /// @param stream generator to start the stream in
+    /// @param robotId the robot's id, see Robot::getId()
+    void select(PhiloxStream &stream, int robotId) const
+    {
+        stream.select(key, gameId, turn, (uint32_t)robotId);
+    }
+};
+
 class RNG
 {
+public:
+    // Exception for a saved state that is not one returned by getState()
+    class InvalidState
+    {
+    };
+
 private:
-    static int boardWidth;
-    static int boardHeight;
+    static thread_local int boardWidth;
+    static thread_local int boardHeight;
+
+    /// @brief Pseudo random number generator. Every thread has its own, so that games
+    /// played on separate threads do not share one. It is seeded non-deterministically
+    /// when a thread first uses it unless a fixed seed is given through seed()
+    static thread_local mt19937 randomGenerator;
+
+    /// @brief true once seedStreams() has been called, until seed() is called
+    static thread_local bool isUsingStreams;
+    static thread_local uint64_t streamSeed;
+    static thread_local uint32_t streamGameId;
+    static thread_local PhiloxStream stream;
 
-    /// @brief Non-deterministic random number generator
-    static random_device randomGenerator;
+    /// @brief first word of a state returned by getState() for counter-based streams
+    static const uint32_t STREAM_STATE_MARKER = 0x4D525453;
 
 public:
+    /// @brief Stream number of the random numbers that are not drawn by a robot
+    /// during its turn (robots are numbered by their ids, which are never negative)
+    static const int REVIVE_STREAM = -1;
+
     /// @brief Initializes the board width & height for the posX & posY
     /// random number generators
     /// @param boardWidth 
     /// @param boardHeight 
     static void init(int boardWidth, int boardHeight);
 
+    /// @brief Reseeds the random number generator so that a run can be reproduced
+    /// @param seed 
+    static void seed(unsigned int seed);
+
+    /// @brief Switches to counter-based streams, so that the random numbers of a robot
+    /// only depend on the seed, the game id, the turn, the robot and how many numbers
+    /// the robot has drawn this turn
+    /// @param seed 
+    /// @param gameId number telling apart games played with the same seed
+    static void seedStreams(uint64_t seed, uint32_t gameId);
+
+    /// @brief Selects the stream the next random numbers are drawn from. Does
+    /// nothing unless seedStreams() has been called
+    /// @param turn the turn being played, 0 while the game is set up
+    /// @param streamIndex id of the robot acting (or being created while the game
+    /// is set up), or REVIVE_STREAM
+    static void selectStream(int turn, int streamIndex);
+
+    /// @brief Returns the streams the robots draw from in a simultaneous turn. With
+    /// counter-based streams these are the streams selectStream() selects for the
+    /// turn, otherwise their key is drawn from the generator
+    /// @param turn the turn being played
+    static TurnStreams turnStreams(int turn);
+
+    /// @brief Returns the complete internal state of the random number generator
+    /// so that a saved game continues with the same random numbers
+    static vector<uint32_t> getState();
+
+    /// @brief Returns the state the random number generator would have after seed(),
+    /// without changing the current state
+    /// @param seed 
+    static vector<uint32_t> seededState(unsigned int seed);
+
+    /// @brief Checks whether a saved state can be restored, e.g. one read from a file
+    /// @param state 
+    /// @return true if state has the length & form of a state returned by getState()
+    static bool isValidState(const vector<uint32_t> &state);
+
+    /// @brief Restores a state returned by getState()
+    /// @param state 
+    /// @exception InvalidState thrown if the state is not valid, see isValidState()
+    static void setState(const vector<uint32_t> &state);
+
+    /// @brief Returns the state a branch of a game continues with, see GameState::fork()
+    /// @param state the state of the game's random number generator
+    /// @param seed the branch's seed
+    /// @return the state with its seed replaced if it is a counter-based stream state,
+    /// otherwise an empty state, meaning that the branch is seeded with seed()
+    static vector<uint32_t> forkedState(const vector<uint32_t> &state, unsigned int seed);
+
     static int posX();
     static int posY();
 
+    /// @brief Picks random cells on the board, all at once
+    /// @param count number of cells
+    /// @param cellX, cellY arrays of count coordinates to fill
+    static void cells(int count, int *cellX, int *cellY);
+
     static int integer(int min, int max);
 };
 
-int RNG::boardWidth = 0;
-int RNG::boardHeight = 0;
-random_device RNG::randomGenerator;
+thread_local int RNG::boardWidth = 0;
+thread_local int RNG::boardHeight = 0;
+thread_local mt19937 RNG::randomGenerator(random_device{}());
+thread_local bool RNG::isUsingStreams = false;
+thread_local uint64_t RNG::streamSeed = 0;
+thread_local uint32_t RNG::streamGameId = 0;
+thread_local PhiloxStream RNG::stream;
 
 void RNG::init(int width, int height)
 {
@@ -51,13 +371,135 @@ void RNG::init(int width, int height)
     RNG::boardHeight = height;
 }
 
+void RNG::seed(unsigned int seed)
+{
+    RNG::randomGenerator.seed(seed);
+    RNG::isUsingStreams = false;
+}
+
+void RNG::seedStreams(uint64_t seed, uint32_t gameId)
+{
+    RNG::isUsingStreams = true;
+    RNG::streamSeed = seed;
+    RNG::streamGameId = gameId;
+
+    selectStream(0, 0);
+}
+
+void RNG::selectStream(int turn, int streamIndex)
+{
+    if (RNG::isUsingStreams)
+    {
+        RNG::stream.select(RNG::streamSeed, RNG::streamGameId, (uint32_t)turn, (uint32_t)streamIndex);
+    }
+}
+
+TurnStreams RNG::turnStreams(int turn)
+{
+    TurnStreams streams;
+    streams.turn = (uint32_t)turn;
+
+    if (RNG::isUsingStreams)
+    {
+        streams.key = RNG::streamSeed;
+        streams.gameId = RNG::streamGameId;
+    }
+    else
+    {
+        // drawn from the game's generator, so a seeded game is reproducible
+        streams.key = (uint64_t)RNG::randomGenerator() << 32;
+        streams.key |= RNG::randomGenerator();
+    }
+
+    return streams;
+}
+
+/// @brief Returns the internal state of a generator as a list of words
+static vector<uint32_t> generatorState(const mt19937 &generator)
+{
+    // mt19937 can only be saved through its stream operator, which writes
+    // every word of its state followed by its position in the state
+    stringstream stateStream;
+    stateStream << generator;
+
+    vector<uint32_t> state;
+    uint32_t word;
+    while (stateStream >> word)
+    {
+        state.push_back(word);
+    }
+
+    return state;
+}
+
+vector<uint32_t> RNG::getState()
+{
+    // Streams are selected afresh for every robot, so the seed & game id are all there is to save
+    if (RNG::isUsingStreams)
+    {
+        return {STREAM_STATE_MARKER, (uint32_t)RNG::streamSeed, (uint32_t)(RNG::streamSeed >> 32), RNG::streamGameId};
+    }
+
+    return generatorState(RNG::randomGenerator);
+}
+
+vector<uint32_t> RNG::seededState(unsigned int seed)
+{
+    return generatorState(mt19937(seed));
+}
+
+bool RNG::isValidState(const vector<uint32_t> &state)
+{
+    if (state.size() == 4 && state[0] == STREAM_STATE_MARKER)
+    {
+        return true;
+    }
+
+    // every word of the generator's state followed by its position in the state
+    return state.size() == mt19937::state_size + 1 && state.back() <= mt19937::state_size;
+}
+
+void RNG::setState(const vector<uint32_t> &state)
+{
+    if (!isValidState(state))
+    {
+        throw InvalidState();
+    }
+
+    if (state.size() == 4 && state[0] == STREAM_STATE_MARKER)
+    {
+        seedStreams(state[1] | (uint64_t)state[2] << 32, state[3]);
+        return;
+    }
+
+    RNG::isUsingStreams = false;
+
+    stringstream stateStream;
+    for (uint32_t word : state)
+    {
+        stateStream << word << ' ';
+    }
+
+    stateStream >> RNG::randomGenerator;
+}
+
+vector<uint32_t> RNG::forkedState(const vector<uint32_t> &state, unsigned int seed)
+{
+    if (state.size() == 4 && state[0] == STREAM_STATE_MARKER)
+    {
+        return {STREAM_STATE_MARKER, seed, 0, state[3]};
+    }
+
+    return {};
+}
+
 /// @brief Generates a random X coordinate in the board
 /// @returns int signifying a random X coordinate on the board
 int RNG::posX()
 {
     uniform_int_distribution<int> randomX(0, boardWidth - 1);
 
-    return randomX(randomGenerator);
+    return isUsingStreams ? randomX(stream) : randomX(randomGenerator);
 }
 
 /// @brief Generates a random Y coordinate in the board
@@ -66,7 +508,19 @@ int RNG::posY()
 {
     uniform_int_distribution<int> randomX(0, boardHeight - 1);
 
-    return randomX(randomGenerator);
+    return isUsingStreams ? randomX(stream) : randomX(randomGenerator);
+}
+
+void RNG::cells(int count, int *cellX, int *cellY)
+{
+    if (isUsingStreams)
+    {
+        randomCells(stream, boardWidth, boardHeight, count, cellX, cellY);
+    }
+    else
+    {
+        randomCells(randomGenerator, boardWidth, boardHeight, count, cellX, cellY);
+    }
 }
 
 /// @brief Generates a random integer value in the range [min, max]. min & max are inclusive
@@ -78,7 +532,7 @@ int RNG::integer(int min, int max)
 {
     uniform_int_distribution<int> randomX(min, max);
 
-    return randomX(randomGenerator);
+    return isUsingStreams ? randomX(stream) : randomX(randomGenerator);
 }
 
 #endif
\ No newline at end of file
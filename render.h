@@ -0,0 +1,333 @@
+/*
+ *
+ * This file contains the RenderPolicy class that decides which turns of a
+ * game are displayed, and the BoardView class that decides which part of the
+ * board is displayed
+ *
+ * --- Code Summary ---
+ * By default every turn is displayed. For long games a policy can instead
+ * display every Nth turn, at most K frames per second, only the turns in
+ * which a robot was killed or evolved, or only the final turn. The final turn
+ * is displayed by every policy.
+ *
+ * Turns that are not displayed skip the board refresh and the interface
+ * entirely. The game itself (and its replay) is played exactly the same, so
+ * the turn number & robot counts shown in a displayed frame are always exact.
+ *
+ * By default the whole board is displayed. A view can instead show a window of
+ * the board at a fixed position, a window that follows a robot around, or an
+ * overview of the whole board shrunk down to a given size.
+ *
+ */
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+class RenderPolicy
+{
+public:
+    enum Mode
+    {
+        EVERY_TURN,
+        EVERY_N_TURNS,
+        FRAME_RATE,
+        ON_EVENTS,
+        FINAL_ONLY
+    };
+
+    // Exception for a turn interval or frame rate that is not positive
+    class InvalidParameter
+    {
+    };
+
+    /// @brief Displays every turn
+    static RenderPolicy everyTurn();
+
+    /// @brief Displays every turn that is a multiple of turns
+    /// @param turns number of turns between displayed turns
+    /// @exception InvalidParameter thrown if turns is less than 1
+    static RenderPolicy everyNTurns(int turns);
+
+    /// @brief Displays a turn only if the last displayed turn was at least
+    /// 1 / framesPerSecond seconds ago
+    /// @param framesPerSecond maximum number of turns displayed per second
+    /// @exception InvalidParameter thrown if framesPerSecond is not positive
+    static RenderPolicy frameRate(double framesPerSecond);
+
+    /// @brief Displays only the turns in which a robot was killed or evolved
+    static RenderPolicy onEvents();
+
+    /// @brief Displays only the final turn
+    static RenderPolicy finalOnly();
+
+    Mode getMode() const;
+
+    /// @brief Decides whether a turn that has just been played is displayed.
+    /// Must be called once after every turn
+    /// @param turn the turn
+    /// @param isFinalTurn true if the game ends after this turn
+    /// @param hadEvents true if a robot was killed or evolved during the turn
+    /// @return true if the turn should be displayed
+    bool shouldDisplay(int turn, bool isFinalTurn, bool hadEvents);
+
+private:
+    Mode mode = EVERY_TURN;
+    int turnInterval = 1;
+    chrono::steady_clock::duration frameInterval = chrono::steady_clock::duration::zero();
+
+    bool hasDisplayedTurn = false;
+    chrono::steady_clock::time_point lastDisplayTime;
+};
+
+inline RenderPolicy RenderPolicy::everyTurn()
+{
+    return RenderPolicy();
+}
+
+inline RenderPolicy RenderPolicy::everyNTurns(int turns)
+{
+    if (turns < 1)
+    {
+        throw InvalidParameter();
+    }
+
+    RenderPolicy policy;
+    policy.mode = EVERY_N_TURNS;
+    policy.turnInterval = turns;
+
+    return policy;
+}
+
+inline RenderPolicy RenderPolicy::frameRate(double framesPerSecond)
+{
+    if (!(framesPerSecond > 0))
+    {
+        throw InvalidParameter();
+    }
+
+    RenderPolicy policy;
+    policy.mode = FRAME_RATE;
+    policy.frameInterval = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1 / framesPerSecond));
+
+    return policy;
+}
+
+inline RenderPolicy RenderPolicy::onEvents()
+{
+    RenderPolicy policy;
+    policy.mode = ON_EVENTS;
+
+    return policy;
+}
+
+inline RenderPolicy RenderPolicy::finalOnly()
+{
+    RenderPolicy policy;
+    policy.mode = FINAL_ONLY;
+
+    return policy;
+}
+
+inline RenderPolicy::Mode RenderPolicy::getMode() const
+{
+    return mode;
+}
+
+inline bool RenderPolicy::shouldDisplay(int turn, bool isFinalTurn, bool hadEvents)
+{
+    bool isDisplayed = isFinalTurn;
+
+    switch (mode)
+    {
+    case EVERY_TURN:
+        isDisplayed = true;
+        break;
+    case EVERY_N_TURNS:
+        isDisplayed = isDisplayed || turn % turnInterval == 0;
+        break;
+    case FRAME_RATE:
+    {
+        auto now = chrono::steady_clock::now();
+
+        if (!hasDisplayedTurn || now - lastDisplayTime >= frameInterval)
+        {
+            isDisplayed = true;
+        }
+
+        if (isDisplayed)
+        {
+            lastDisplayTime = now;
+        }
+        break;
+    }
+    case ON_EVENTS:
+        isDisplayed = isDisplayed || hadEvents;
+        break;
+    case FINAL_ONLY:
+        break;
+    }
+
+    hasDisplayedTurn = hasDisplayedTurn || isDisplayed;
+
+    return isDisplayed;
+}
+
+class BoardView
+{
+public:
+    enum Mode
+    {
+        FULL,
+        WINDOW,
+        FOLLOW,
+        OVERVIEW
+    };
+
+    // Exception for a view size that is not positive
+    class InvalidParameter
+    {
+    };
+
+    /// @brief Displays the whole board
+    static BoardView full();
+
+    /// @brief Displays a window of the board at a fixed position
+    /// @param left X position of the leftmost column of the window
+    /// @param top Y position of the top row of the window
+    /// @param width number of columns in the window
+    /// @param height number of rows in the window
+    /// @exception InvalidParameter thrown if the window is empty or starts at a negative position
+    static BoardView window(int left, int top, int width, int height);
+
+    /// @brief Displays a window of the board centered on a robot. While the robot is
+    /// waiting to be revived, the window stays where the robot was last seen
+    /// @param robotName name of the robot to follow
+    /// @param width number of columns in the window
+    /// @param height number of rows in the window
+    /// @exception InvalidParameter thrown if the window is empty
+    static BoardView follow(const string &robotName, int width, int height);
+
+    /// @brief Displays the whole board shrunk down to at most columns x rows characters
+    /// @exception InvalidParameter thrown if columns or rows is not positive
+    static BoardView overview(int columns, int rows);
+
+    /*---------------------------------------------*/
+    /*                 Accessors                   */
+    /*---------------------------------------------*/
+
+    Mode getMode() const;
+    const string &getRobotName() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    /// @brief Works out the position of the window on a board of the given size,
+    /// keeping the whole window inside the board
+    /// @param boardWidth board width
+    /// @param boardHeight board height
+    /// @param centerX X position the window should be centered on (only used when following a robot)
+    /// @param centerY Y position the window should be centered on (only used when following a robot)
+    /// @param left X position of the leftmost column of the window
+    /// @param top Y position of the top row of the window
+    void placeWindow(int boardWidth, int boardHeight, int centerX, int centerY, int &left, int &top) const;
+
+private:
+    Mode mode = FULL;
+    string robotName;
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+};
+
+inline BoardView BoardView::full()
+{
+    return BoardView();
+}
+
+inline BoardView BoardView::window(int left, int top, int width, int height)
+{
+    if (left < 0 || top < 0 || width < 1 || height < 1)
+    {
+        throw InvalidParameter();
+    }
+
+    BoardView view;
+    view.mode = WINDOW;
+    view.left = left;
+    view.top = top;
+    view.width = width;
+    view.height = height;
+
+    return view;
+}
+
+inline BoardView BoardView::follow(const string &robotName, int width, int height)
+{
+    if (width < 1 || height < 1)
+    {
+        throw InvalidParameter();
+    }
+
+    BoardView view;
+    view.mode = FOLLOW;
+    view.robotName = robotName;
+    view.width = width;
+    view.height = height;
+
+    return view;
+}
+
+inline BoardView BoardView::overview(int columns, int rows)
+{
+    if (columns < 1 || rows < 1)
+    {
+        throw InvalidParameter();
+    }
+
+    BoardView view;
+    view.mode = OVERVIEW;
+    view.width = columns;
+    view.height = rows;
+
+    return view;
+}
+
+inline BoardView::Mode BoardView::getMode() const
+{
+    return mode;
+}
+
+inline const string &BoardView::getRobotName() const
+{
+    return robotName;
+}
+
+inline int BoardView::getWidth() const
+{
+    return width;
+}
+
+inline int BoardView::getHeight() const
+{
+    return height;
+}
+
+inline void BoardView::placeWindow(int boardWidth, int boardHeight, int centerX, int centerY, int &left, int &top) const
+{
+    int windowWidth = min(width, boardWidth);
+    int windowHeight = min(height, boardHeight);
+
+    left = mode == FOLLOW ? centerX - windowWidth / 2 : this->left;
+    top = mode == FOLLOW ? centerY - windowHeight / 2 : this->top;
+
+    left = max(0, min(left, boardWidth - windowWidth));
+    top = max(0, min(top, boardHeight - windowHeight));
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ *
+ * This file contains the replay viewer that shows any turn of a game
+ * recorded in a replay file (see replay.h)
+ *
+ * --- Usage ---
+ * replay.out <replay file> [turn]
+ *
+ * If a turn is given, only that turn is shown. Otherwise the viewer starts at
+ * the first turn and reads commands from the terminal:
+ *
+ *   <enter>              show the next turn
+ *   <number>             jump to that turn
+ *   q                    quit
+ *
+ */
+
+#include <iostream>
+#include <string>
+
+#include "replay.h"
+
+using namespace std;
+
+/// @brief Prints the board, the action log & every robot of a frame
+/// @param replay the replay the frame was read from
+/// @param frame the frame
+void showFrame(const ReplayReader &replay, const ReplayReader::Frame &frame)
+{
+    int aliveCount = 0;
+    int revivingCount = 0;
+
+    // the board is drawn row by row, with a robot's first letter at its position
+    string board((replay.getWidth() + 3) * (replay.getHeight() + 2), ' ');
+    int rowLength = replay.getWidth() + 3;
+
+    for (int y = 0; y < replay.getHeight() + 2; y++)
+    {
+        bool isBorder = y == 0 || y == replay.getHeight() + 1;
+
+        board[y * rowLength] = isBorder ? '+' : '|';
+        board[y * rowLength + replay.getWidth() + 1] = isBorder ? '+' : '|';
+        board[y * rowLength + replay.getWidth() + 2] = '\n';
+
+        if (isBorder)
+        {
+            board.replace(y * rowLength + 1, replay.getWidth(), replay.getWidth(), '-');
+        }
+    }
+
+    for (const ReplayRobot &robot : frame.robots)
+    {
+        if (robot.isReviving)
+        {
+            revivingCount++;
+            continue;
+        }
+
+        aliveCount++;
+
+        if (robot.posX < replay.getWidth() && robot.posY < replay.getHeight() && !robot.name.empty())
+        {
+            board[(robot.posY + 1) * rowLength + robot.posX + 1] = robot.name[0];
+        }
+    }
+
+    cout << "[Turn " << frame.turn << " of " << replay.getLastTurn() << "]\n\n";
+    cout << "Robots alive: " << aliveCount << "\n";
+    cout << "Robots waiting to revive: " << revivingCount << "\n\n";
+    cout << "[Actions]\n" << frame.actionLog << "\n";
+    cout << board << "\n";
+
+    cout << "[Robots]\n";
+    for (const ReplayRobot &robot : frame.robots)
+    {
+        cout << robot.name << " (" << robotTypeName(robot.type) << ") at " << robot.posX << ", " << robot.posY
+             << ", " << robot.lives << " lives" << (robot.isReviving ? ", waiting to revive" : "") << "\n";
+    }
+
+    cout << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 3)
+    {
+        cerr << "Usage: " << argv[0] << " <replay file> [turn]" << endl;
+        return 1;
+    }
+
+    string replayFilename = argv[1];
+
+    try
+    {
+        ReplayReader replay(replayFilename);
+
+        if (argc == 3)
+        {
+            showFrame(replay, replay.seek(stoi(argv[2])));
+            return 0;
+        }
+
+        int turn = replay.getFirstTurn();
+        showFrame(replay, replay.seek(turn));
+
+        string command;
+        while (getline(cin, command) && command != "q")
+        {
+            int requestedTurn = turn + 1;
+
+            try
+            {
+                if (!command.empty())
+                {
+                    requestedTurn = stoi(command);
+                }
+
+                showFrame(replay, replay.seek(requestedTurn));
+                turn = requestedTurn;
+            }
+            catch (const logic_error &)
+            {
+                cout << "[ERROR] Enter a turn number, nothing for the next turn or q to quit" << endl;
+            }
+            catch (ReplayReader::TurnNotRecorded)
+            {
+                cout << "[ERROR] Turn " << requestedTurn << " is not part of the replay (turns " << replay.getFirstTurn()
+                     << " to " << replay.getLastTurn() << ")" << endl;
+            }
+        }
+    }
+    catch (MappedFile::OpeningError)
+    {
+        cerr << "[ERROR] Error opening replay file " << replayFilename << endl;
+        return 1;
+    }
+    catch (ReplayReader::InvalidReplay)
+    {
+        cerr << "[ERROR] The replay file is invalid" << endl;
+        return 1;
+    }
+    catch (ReplayReader::TurnNotRecorded)
+    {
+        cerr << "[ERROR] The turn is not part of the replay" << endl;
+        return 1;
+    }
+    catch (const logic_error &)
+    {
+        cerr << "[ERROR] Invalid turn " << argv[2] << endl;
+        return 1;
+    }
+
+    return 0;
+}
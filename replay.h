@@ -0,0 +1,727 @@
+/*
+ *
+ * This file contains the replay format that records every turn of a game so
+ * that any turn can be looked at again after the game has ended
+ *
+ * --- File Layout ---
+ *
+ *   [Header]    magic "RBRP", version, board width & height & keyframe
+ *               interval (20 bytes)
+ *   [Frames]    one frame per turn: kind ('K' or 'D'), turn, payload size
+ *               and payload
+ *   [Index]     file offset & turn of every keyframe (16 bytes each)
+ *   [Trailer]   offset of the index, number of keyframes, last turn & magic
+ *               "RBRI" (24 bytes)
+ *
+ * A keyframe ('K') holds every robot: its id, type, position, lives, whether it
+ * is waiting to be revived and its name. A delta ('D') only holds what changed
+ * since the previous frame: the robots that were added (with every field), the
+ * robots whose position, lives or revive status changed and the ids of the
+ * robots that were removed. An evolved robot is a new robot object, so it is
+ * recorded as a removal & an addition. Both kinds of frame end with the turn's
+ * action log. All numbers inside frames are unsigned LEB128 varints, the header,
+ * index & trailer are stored in the byte order of the machine that wrote them.
+ *
+ * --- Code Summary ---
+ * ReplayWriter records a frame after every turn. It keeps the robots of the
+ * previous frame in a table indexed by robot id (ids count up from 0 in every
+ * game, and a resumed game keeps the ids it was saved with), so the changes of
+ * a turn are found with one pass over the robot queues.
+ *
+ * ReplayReader maps a replay file and seeks to a turn by decoding the last
+ * keyframe at or before it and applying the deltas after it, which is at most
+ * KEYFRAME_INTERVAL - 1 frames no matter how long the game was. If the game was
+ * stopped before the index was written, the index is rebuilt by skipping over
+ * the frames.
+ *
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+#include "robot.h"
+
+using namespace std;
+
+struct ReplayHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t keyframeInterval;
+};
+
+struct ReplayIndexEntry
+{
+    /// @brief file offset of the keyframe
+    uint64_t offset;
+    int32_t turn;
+    uint32_t reserved;
+};
+
+struct ReplayTrailer
+{
+    /// @brief file offset of the first ReplayIndexEntry
+    uint64_t indexOffset;
+    uint32_t keyframeCount;
+    int32_t lastTurn;
+    char magic[4];
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ReplayHeader) == 20, "ReplayHeader must not contain padding");
+static_assert(sizeof(ReplayIndexEntry) == 16, "ReplayIndexEntry must not contain padding");
+static_assert(sizeof(ReplayTrailer) == 24, "ReplayTrailer must not contain padding");
+
+const char REPLAY_MAGIC[4] = {'R', 'B', 'R', 'P'};
+const char REPLAY_INDEX_MAGIC[4] = {'R', 'B', 'R', 'I'};
+const uint32_t REPLAY_VERSION = 1;
+
+const char REPLAY_KEYFRAME = 'K';
+const char REPLAY_DELTA = 'D';
+
+/// @brief A robot as recorded in a replay
+struct ReplayRobot
+{
+    int id = 0;
+    RobotType type = INVALID_ROBOT_TYPE;
+    int posX = 0;
+    int posY = 0;
+    int lives = 0;
+
+    /// @brief true if the robot is waiting in the revive queue
+    bool isReviving = false;
+
+    string name;
+};
+
+/// @brief Appends an unsigned LEB128 varint
+inline void appendVarint(string &output, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        output += (char)(value | 0x80);
+        value >>= 7;
+    }
+
+    output += (char)value;
+}
+
+class ReplayWriter
+{
+private:
+    ofstream replayFile;
+
+    /// @brief number of bytes written to the file so far
+    uint64_t fileSize = 0;
+
+    int framesSinceKeyframe = 0;
+    int lastTurn = -1;
+    vector<ReplayIndexEntry> keyframes;
+
+    /// @brief robots of the previous frame, indexed by robot id
+    vector<ReplayRobot> previousRobots;
+
+    /// @brief number of the last frame each robot in previousRobots was part of
+    vector<int> lastFrameSeen;
+
+    /// @brief ids of the robots in the previous frame
+    vector<int> previousIds;
+    vector<int> currentIds;
+    int frameNumber = 0;
+
+    /// @brief payload of the frame being recorded, reused between frames
+    string payload;
+    string added;
+    string changed;
+
+    void write(const char *data, size_t size);
+    void appendRobot(string &output, const ReplayRobot &robot);
+    int tableIndex(int id);
+
+public:
+    /// @brief Number of frames between two keyframes
+    static const int KEYFRAME_INTERVAL = 64;
+
+    ~ReplayWriter();
+
+    /// @brief Starts a new replay file. Nothing is recorded until a file is opened
+    /// @param filename path of the replay file
+    /// @param width board width
+    /// @param height board height
+    void open(const string &filename, int width, int height);
+
+    /// @brief Writes the keyframe index and closes the replay file
+    void close();
+
+    bool isOpen() const;
+
+    /// @brief Records the robots in Robot::robotDeque & Robot::reviveDeque as the given turn
+    /// @param turn the turn that has just been played
+    /// @param actionLog the turn's action log
+    void record(int turn, const string &actionLog);
+};
+
+inline ReplayWriter::~ReplayWriter()
+{
+    close();
+}
+
+inline void ReplayWriter::open(const string &filename, int width, int height)
+{
+    close();
+
+    replayFile.open(filename, ofstream::binary | ofstream::trunc);
+    if (!replayFile.is_open())
+    {
+        return;
+    }
+
+    fileSize = 0;
+    framesSinceKeyframe = 0;
+    lastTurn = -1;
+    keyframes.clear();
+    previousRobots.clear();
+    lastFrameSeen.clear();
+    previousIds.clear();
+    frameNumber = 0;
+
+    ReplayHeader header = {};
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_VERSION;
+    header.width = width;
+    header.height = height;
+    header.keyframeInterval = KEYFRAME_INTERVAL;
+
+    write((const char *)&header, sizeof(header));
+}
+
+inline void ReplayWriter::close()
+{
+    if (!replayFile.is_open())
+    {
+        return;
+    }
+
+    ReplayTrailer trailer = {};
+    trailer.indexOffset = fileSize;
+    trailer.keyframeCount = (uint32_t)keyframes.size();
+    trailer.lastTurn = lastTurn;
+    memcpy(trailer.magic, REPLAY_INDEX_MAGIC, sizeof(trailer.magic));
+
+    write((const char *)keyframes.data(), keyframes.size() * sizeof(ReplayIndexEntry));
+    write((const char *)&trailer, sizeof(trailer));
+
+    replayFile.close();
+}
+
+inline bool ReplayWriter::isOpen() const
+{
+    return replayFile.is_open();
+}
+
+inline void ReplayWriter::write(const char *data, size_t size)
+{
+    replayFile.write(data, size);
+    fileSize += size;
+}
+
+inline void ReplayWriter::appendRobot(string &output, const ReplayRobot &robot)
+{
+    appendVarint(output, robot.id);
+    appendVarint(output, robot.type);
+    appendVarint(output, robot.posX);
+    appendVarint(output, robot.posY);
+    appendVarint(output, robot.lives);
+    appendVarint(output, robot.isReviving);
+    appendVarint(output, (uint32_t)robot.name.size());
+    output += robot.name;
+}
+
+/// @brief Returns the index of a robot in previousRobots & lastFrameSeen,
+/// growing both tables if the robot is not part of them yet
+/// @param id id of the robot
+inline int ReplayWriter::tableIndex(int id)
+{
+    if (id >= (int)previousRobots.size())
+    {
+        previousRobots.resize(id + 1);
+        lastFrameSeen.resize(id + 1, -1);
+    }
+
+    return id;
+}
+
+inline void ReplayWriter::record(int turn, const string &actionLog)
+{
+    if (!replayFile.is_open())
+    {
+        return;
+    }
+
+    bool isKeyframe = framesSinceKeyframe == 0;
+    framesSinceKeyframe = (framesSinceKeyframe + 1) % KEYFRAME_INTERVAL;
+    frameNumber++;
+
+    payload.clear();
+    added.clear();
+    changed.clear();
+    currentIds.clear();
+
+    int addedCount = 0;
+    int changedCount = 0;
+
+    auto recordQueue = [&](Deque<Robot *> &queue, bool isReviving) {
+        for (int i = 0; i < queue.size(); i++)
+        {
+            const Robot *robot = queue[i];
+            int id = robot->getId();
+            int index = tableIndex(id);
+
+            ReplayRobot &previous = previousRobots[index];
+            bool isNew = lastFrameSeen[index] != frameNumber - 1;
+
+            if (isNew)
+            {
+                previous.id = id;
+                previous.type = robotTypeFromName(robot->getType());
+                previous.name = robot->getName();
+            }
+
+            bool hasChanged = previous.posX != robot->getPositionX() || previous.posY != robot->getPositionY() ||
+                              previous.lives != robot->getLives() || previous.isReviving != isReviving;
+
+            previous.posX = robot->getPositionX();
+            previous.posY = robot->getPositionY();
+            previous.lives = robot->getLives();
+            previous.isReviving = isReviving;
+
+            lastFrameSeen[index] = frameNumber;
+            currentIds.push_back(id);
+
+            if (isKeyframe || isNew)
+            {
+                appendRobot(added, previous);
+                addedCount++;
+            }
+            else if (hasChanged)
+            {
+                appendVarint(changed, id);
+                appendVarint(changed, previous.posX);
+                appendVarint(changed, previous.posY);
+                appendVarint(changed, previous.lives);
+                appendVarint(changed, previous.isReviving);
+                changedCount++;
+            }
+        }
+    };
+
+    recordQueue(Robot::robotDeque, false);
+    recordQueue(Robot::reviveDeque, true);
+
+    appendVarint(payload, addedCount);
+    payload += added;
+
+    if (!isKeyframe)
+    {
+        appendVarint(payload, changedCount);
+        payload += changed;
+
+        // Robots of the previous frame that were not seen in this one have been removed
+        int removedCount = 0;
+        for (int id : previousIds)
+        {
+            if (lastFrameSeen[id] != frameNumber)
+            {
+                removedCount++;
+            }
+        }
+
+        appendVarint(payload, removedCount);
+        for (int id : previousIds)
+        {
+            if (lastFrameSeen[id] != frameNumber)
+            {
+                appendVarint(payload, id);
+            }
+        }
+    }
+
+    appendVarint(payload, (uint32_t)actionLog.size());
+    payload += actionLog;
+
+    if (isKeyframe)
+    {
+        keyframes.push_back({fileSize, turn, 0});
+    }
+
+    string frameHeader(1, isKeyframe ? REPLAY_KEYFRAME : REPLAY_DELTA);
+    appendVarint(frameHeader, turn);
+    appendVarint(frameHeader, (uint32_t)payload.size());
+
+    write(frameHeader.data(), frameHeader.size());
+    write(payload.data(), payload.size());
+
+    previousIds.swap(currentIds);
+    lastTurn = turn;
+}
+
+class ReplayReader
+{
+public:
+    // Exception for files that are not valid replays
+    class InvalidReplay
+    {
+    };
+
+    // Exception for turns that are not part of the replay
+    class TurnNotRecorded
+    {
+    };
+
+    /// @brief The state of the game after one turn
+    struct Frame
+    {
+        int turn = 0;
+
+        /// @brief every robot, ordered by id
+        vector<ReplayRobot> robots;
+
+        string actionLog;
+    };
+
+    /// @brief Opens a replay file
+    /// @param filename path of the replay file
+    /// @exception MappedFile::OpeningError thrown if the file could not be opened
+    /// @exception InvalidReplay thrown if the file is not a valid replay
+    ReplayReader(const string &filename);
+
+    /*---------------------------------------------*/
+    /*                 Accessors                   */
+    /*---------------------------------------------*/
+
+    int getWidth() const;
+    int getHeight() const;
+    int getFirstTurn() const;
+    int getLastTurn() const;
+
+    /// @brief Reconstructs the state of the game after the given turn
+    /// @param turn the turn
+    /// @return the frame of the turn
+    /// @exception TurnNotRecorded thrown if the turn is not part of the replay
+    /// @exception InvalidReplay thrown if a frame is damaged
+    Frame seek(int turn) const;
+
+private:
+    MappedFile replayFile;
+    ReplayHeader header;
+    vector<ReplayIndexEntry> keyframes;
+    int lastTurn = -1;
+
+    void readIndex();
+    void rebuildIndex(uint64_t framesEnd);
+};
+
+/// @brief Reads values from replay data, checking that they do not run past its end
+class ReplayDecoder
+{
+private:
+    string_view data;
+    size_t position;
+
+public:
+    ReplayDecoder(string_view data, size_t position)
+    {
+        this->data = data;
+        this->position = position;
+    }
+
+    size_t getPosition() const
+    {
+        return position;
+    }
+
+    bool atEnd() const
+    {
+        return position >= data.size();
+    }
+
+    char readByte()
+    {
+        if (position >= data.size())
+        {
+            throw ReplayReader::InvalidReplay();
+        }
+
+        return data[position++];
+    }
+
+    uint32_t readVarint()
+    {
+        uint32_t value = 0;
+
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            unsigned char byte = readByte();
+            value |= (uint32_t)(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+
+        throw ReplayReader::InvalidReplay();
+    }
+
+    string_view readBytes(size_t length)
+    {
+        if (length > data.size() - position)
+        {
+            throw ReplayReader::InvalidReplay();
+        }
+
+        string_view bytes = data.substr(position, length);
+        position += length;
+
+        return bytes;
+    }
+};
+
+inline ReplayReader::ReplayReader(const string &filename) : replayFile(filename)
+{
+    string_view data = replayFile.getText();
+
+    if (data.size() < sizeof(ReplayHeader) || memcmp(data.data(), REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0)
+    {
+        throw InvalidReplay();
+    }
+
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.version != REPLAY_VERSION || header.width <= 0 || header.height <= 0)
+    {
+        throw InvalidReplay();
+    }
+
+    readIndex();
+
+    if (keyframes.empty())
+    {
+        throw InvalidReplay();
+    }
+}
+
+/// @brief Reads the keyframe index from the end of the file, or rebuilds
+/// it if the file has no valid trailer
+inline void ReplayReader::readIndex()
+{
+    string_view data = replayFile.getText();
+
+    if (data.size() < sizeof(ReplayHeader) + sizeof(ReplayTrailer))
+    {
+        rebuildIndex(data.size());
+        return;
+    }
+
+    ReplayTrailer trailer;
+    memcpy(&trailer, data.data() + data.size() - sizeof(trailer), sizeof(trailer));
+
+    uint64_t indexSize = (uint64_t)trailer.keyframeCount * sizeof(ReplayIndexEntry);
+
+    if (memcmp(trailer.magic, REPLAY_INDEX_MAGIC, sizeof(trailer.magic)) != 0 ||
+        trailer.indexOffset < sizeof(ReplayHeader) || trailer.indexOffset > data.size() ||
+        trailer.indexOffset + indexSize + sizeof(trailer) != data.size())
+    {
+        rebuildIndex(data.size());
+        return;
+    }
+
+    keyframes.resize(trailer.keyframeCount);
+    memcpy(keyframes.data(), data.data() + trailer.indexOffset, indexSize);
+    lastTurn = trailer.lastTurn;
+
+    for (const ReplayIndexEntry &keyframe : keyframes)
+    {
+        if (keyframe.offset < sizeof(ReplayHeader) || keyframe.offset >= trailer.indexOffset)
+        {
+            throw InvalidReplay();
+        }
+    }
+}
+
+/// @brief Finds the keyframes by skipping over every frame. Frames that were
+/// only partly written are ignored
+/// @param framesEnd file offset where the frames end
+inline void ReplayReader::rebuildIndex(uint64_t framesEnd)
+{
+    string_view frames = replayFile.getText().substr(0, framesEnd);
+    ReplayDecoder decoder(frames, sizeof(ReplayHeader));
+
+    keyframes.clear();
+
+    try
+    {
+        while (!decoder.atEnd())
+        {
+            size_t offset = decoder.getPosition();
+            char kind = decoder.readByte();
+            int turn = decoder.readVarint();
+            decoder.readBytes(decoder.readVarint());
+
+            if (kind == REPLAY_KEYFRAME)
+            {
+                keyframes.push_back({offset, turn, 0});
+            }
+            else if (kind != REPLAY_DELTA)
+            {
+                break;
+            }
+
+            lastTurn = turn;
+        }
+    }
+    catch (InvalidReplay)
+    {
+        // the last frame was cut off
+    }
+}
+
+inline int ReplayReader::getWidth() const
+{
+    return header.width;
+}
+
+inline int ReplayReader::getHeight() const
+{
+    return header.height;
+}
+
+inline int ReplayReader::getFirstTurn() const
+{
+    return keyframes.front().turn;
+}
+
+inline int ReplayReader::getLastTurn() const
+{
+    return lastTurn;
+}
+
+inline ReplayReader::Frame ReplayReader::seek(int turn) const
+{
+    if (turn < getFirstTurn() || turn > getLastTurn())
+    {
+        throw TurnNotRecorded();
+    }
+
+    // last keyframe at or before the turn
+    auto keyframe = upper_bound(keyframes.begin(), keyframes.end(), turn, [](int turn, const ReplayIndexEntry &entry) {
+        return turn < entry.turn;
+    });
+    keyframe--;
+
+    ReplayDecoder decoder(replayFile.getText(), keyframe->offset);
+
+    /// @brief robots of the frame that was decoded last, by id
+    unordered_map<int, ReplayRobot> robots;
+
+    auto readRobot = [&]() {
+        ReplayRobot robot;
+        robot.id = decoder.readVarint();
+        robot.type = (RobotType)decoder.readVarint();
+        robot.posX = decoder.readVarint();
+        robot.posY = decoder.readVarint();
+        robot.lives = decoder.readVarint();
+        robot.isReviving = decoder.readVarint() != 0;
+        robot.name = string(decoder.readBytes(decoder.readVarint()));
+
+        robots[robot.id] = robot;
+    };
+
+    Frame frame;
+
+    while (true)
+    {
+        char kind = decoder.readByte();
+        frame.turn = decoder.readVarint();
+        decoder.readVarint(); // payload size
+
+        if (kind == REPLAY_KEYFRAME)
+        {
+            robots.clear();
+
+            for (uint32_t count = decoder.readVarint(); count > 0; count--)
+            {
+                readRobot();
+            }
+        }
+        else if (kind == REPLAY_DELTA)
+        {
+            for (uint32_t count = decoder.readVarint(); count > 0; count--)
+            {
+                readRobot();
+            }
+
+            for (uint32_t count = decoder.readVarint(); count > 0; count--)
+            {
+                auto robot = robots.find(decoder.readVarint());
+                if (robot == robots.end())
+                {
+                    throw InvalidReplay();
+                }
+
+                robot->second.posX = decoder.readVarint();
+                robot->second.posY = decoder.readVarint();
+                robot->second.lives = decoder.readVarint();
+                robot->second.isReviving = decoder.readVarint() != 0;
+            }
+
+            for (uint32_t count = decoder.readVarint(); count > 0; count--)
+            {
+                robots.erase(decoder.readVarint());
+            }
+        }
+        else
+        {
+            throw InvalidReplay();
+        }
+
+        string_view actionLog = decoder.readBytes(decoder.readVarint());
+
+        if (frame.turn == turn)
+        {
+            frame.actionLog = string(actionLog);
+            break;
+        }
+
+        if (frame.turn > turn)
+        {
+            throw InvalidReplay();
+        }
+    }
+
+    frame.robots.reserve(robots.size());
+    for (auto &robot : robots)
+    {
+        frame.robots.push_back(move(robot.second));
+    }
+
+    sort(frame.robots.begin(), frame.robots.end(), [](const ReplayRobot &a, const ReplayRobot &b) {
+        return a.id < b.id;
+    });
+
+    return frame;
+}
+
+#endif
@@ -9,11 +9,16 @@
 #define ROBOT_H
 
 #include <string>
+#include <string_view>
 #include <cmath>
 
+#include "board.h"
 #include "deque.h"
+#include "intent.h"
 #include "log.h"
+#include "random.h"
 #include "robotbase.h"
+#include "tracer.h"
 
 using namespace std;
 
@@ -28,12 +33,15 @@ public:
 /// @brief Tramples the robot at this robot's current position
 inline void TramplingRobot::trample()
 {
-    for (int i = 0; i < Robot::robotDeque.size(); i++)
+    // robotDeque is thread_local, so it is looked up once rather than for every robot
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    for (int i = 0; i < robots.size(); i++)
     {
-        if (Robot::robotDeque[i]->getPositionX() == this->getPositionX() && Robot::robotDeque[i]->getPositionY() == this->getPositionY() && Robot::robotDeque[i] != this)
+        if (robots[i]->getPositionX() == this->getPositionX() && robots[i]->getPositionY() == this->getPositionY() && robots[i] != this)
         {
-            Log::trample(this->getName(), Robot::robotDeque[i]->getName());
-            this->kill(Robot::robotDeque[i]);
+            Log::trample(this->getName(), robots[i]->getName());
+            this->kill(robots[i]);
             return;
         }
     }
@@ -139,6 +147,10 @@ private:
 public:
     Cell look(int relativeX, int relativeY);
 
+    int lookAround(Cell cells[8]);
+
+    int lookAround(const TurnView &view, TurnIntent &intent, Cell cells[8]) const;
+
     int getLookRange() const;
 };
 
@@ -158,19 +170,104 @@ inline Cell LookingRobot::look(int relativeX, int relativeY)
         return Cell(relativeX, relativeY);
     }
 
+    // A cell that is clear in the bitboard is empty, without looking through every robot
+    if (occupiedBits != nullptr && !occupiedBits->test(positionX, positionY))
+    {
+        return Cell(true, nullptr, relativeX, relativeY);
+    }
+
     // Checking if a any robots match the looking position
-    for (int i = 0; i < robotDeque.size(); i++)
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    for (int i = 0; i < robots.size(); i++)
     {
-        if (robotDeque[i]->getPositionX() == positionX && robotDeque[i]->getPositionY() == positionY)
+        if (robots[i]->getPositionX() == positionX && robots[i]->getPositionY() == positionY)
         {
-            Log::enemySpotted(this->getName(), robotDeque[i]->getName(), positionX, positionY);
-            return Cell(true, robotDeque[i], relativeX, relativeY);
+            Log::enemySpotted(this->getName(), robots[i]->getName(), positionX, positionY);
+            return Cell(true, robots[i], relativeX, relativeY);
         }
     }
 
     return Cell(true, nullptr, relativeX, relativeY);
 }
 
+/// @brief Looks at all adjacent cells, in the order robots have always looked at them
+/// @param cells receives every adjacent cell inside the board
+/// @return number of cells written to cells
+inline int LookingRobot::lookAround(Cell cells[8])
+{
+    int cellCount = 0;
+
+    // With no adjacent cell set in the bitboard every adjacent cell is empty, which one
+    // look at the 3 rows around the robot tells instead of a look at every cell
+    bool isAlone = occupiedBits != nullptr && !occupiedBits->isAnyNeighbourSet(this->getPositionX(), this->getPositionY());
+
+    for (int i = -1; i <= 1; i++)
+    {
+        for (int j = -1; j <= 1; j++)
+        {
+            if (i == 0 && j == 0)
+                continue;
+
+            if (isAlone)
+            {
+                if (TurnView::isInside(this->getPositionX() + i, this->getPositionY() + j))
+                {
+                    cells[cellCount++] = Cell(true, nullptr, i, j);
+                }
+
+                continue;
+            }
+
+            Cell cell = look(i, j);
+
+            if (cell.isValid)
+            {
+                cells[cellCount++] = cell;
+            }
+        }
+    }
+
+    return cellCount;
+}
+
+/// @brief Looks at all adjacent cells as they were at the start of a simultaneous turn,
+/// in the same order as executeTurn() looks at them
+/// @param view the board at the start of the turn
+/// @param intent every robot seen is added to its spotted robots
+/// @param cells receives every adjacent cell inside the board
+/// @return number of cells written to cells
+inline int LookingRobot::lookAround(const TurnView &view, TurnIntent &intent, Cell cells[8]) const
+{
+    int cellCount = 0;
+
+    for (int i = -1; i <= 1; i++)
+    {
+        for (int j = -1; j <= 1; j++)
+        {
+            if (i == 0 && j == 0)
+                continue;
+
+            int positionX = this->getPositionX() + i;
+            int positionY = this->getPositionY() + j;
+
+            if (!TurnView::isInside(positionX, positionY))
+                continue;
+
+            Robot *occupant = view.occupant(positionX, positionY);
+
+            if (occupant != nullptr)
+            {
+                intent.spot(occupant);
+            }
+
+            cells[cellCount++] = Cell(true, occupant, i, j);
+        }
+    }
+
+    return cellCount;
+}
+
 inline int LookingRobot::getLookRange() const
 {
     return this->lookRange;
@@ -181,6 +278,9 @@ class FiringRobot : public virtual Robot
 private:
     int fireRange = 1;
 
+    template <typename Draw>
+    int pickOccupiedCells(const SpatialIndex &cells, int fromX, int fromY, int shots, Draw draw, int *targetX, int *targetY) const;
+
 public:
     // Exception for when the robot attempts to shoot itself
     class AttemptToShootSelf
@@ -189,6 +289,12 @@ public:
 
     virtual void fire(int relativeX, int relativeY);
 
+    void aimAnywhere(int *targetX, int *targetY, int shots) const;
+    int aimAtRobots(int *targetX, int *targetY, int shots) const;
+    int aimAtRobots(const TurnView &view, IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const;
+    void aimInRange(IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const;
+    void aimAnywhere(IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const;
+
     int getFireRange() const;
 
     void setFireRange(int fireRange);
@@ -212,18 +318,194 @@ inline void FiringRobot::fire(int relativeX, int relativeY)
     }
 
     Log::fire(this->getName(), positionX, positionY);
-    
-    for (int i = 0; i < Robot::robotDeque.size(); i++)
+
+    // a shot at a cell that is clear in the bitboard misses
+    if (occupiedBits != nullptr && !occupiedBits->test(positionX, positionY))
     {
-        if (Robot::robotDeque[i]->getPositionX() == positionX && Robot::robotDeque[i]->getPositionY() == positionY)
+        return;
+    }
+
+    Deque<Robot *> &robots = Robot::robotDeque;
+
+    for (int i = 0; i < robots.size(); i++)
+    {
+        if (robots[i]->getPositionX() == positionX && robots[i]->getPositionY() == positionY)
         {
-            Log::fireHit(this->getName(), Robot::robotDeque[i]->getName());
-            this->kill(Robot::robotDeque[i]);
+            Log::fireHit(this->getName(), robots[i]->getName());
+            this->kill(robots[i]);
             return;
         }
     }
 }
 
+/// @brief Aims shots in a simultaneous turn at random cells inside the board
+/// within the fire range, the same way executeTurn() picks them
+/// @param random random number generator of the robot
+/// @param intent receives the shots
+/// @param fromX X position the robot fires from
+/// @param fromY Y position the robot fires from
+/// @param shots number of shots
+inline void FiringRobot::aimInRange(IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const
+{
+    while (shots > 0)
+    {
+        int offset = getFireRange();
+
+        int relativeX = random.integer(-offset, offset);
+
+        offset = offset - abs(relativeX);
+
+        int relativeY = random.integer(-offset, offset);
+
+        if ((relativeX == 0 && relativeY == 0) || !TurnView::isInside(fromX + relativeX, fromY + relativeY))
+            continue;
+
+        intent.fireAt(fromX + relativeX, fromY + relativeY);
+        shots--;
+    }
+}
+
+/// @brief Picks cells anywhere on the board other than the robot's own cell to fire at
+/// @param targetX, targetY arrays of shots coordinates to fill
+/// @param shots number of cells to pick
+inline void FiringRobot::aimAnywhere(int *targetX, int *targetY, int shots) const
+{
+    RNG::cells(shots, targetX, targetY);
+
+    for (int i = 0; i < shots; i++)
+    {
+        while (targetX[i] == getPositionX() && targetY[i] == getPositionY())
+        {
+            RNG::cells(1, &targetX[i], &targetY[i]);
+        }
+    }
+}
+
+/// @brief Aims shots in a simultaneous turn at random cells anywhere on the board
+/// @param random random number generator of the robot
+/// @param intent receives the shots
+/// @param fromX X position the robot fires from, which is never fired at
+/// @param fromY Y position the robot fires from, which is never fired at
+/// @param shots number of shots
+inline void FiringRobot::aimAnywhere(IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const
+{
+    int targetX[TurnIntent::MAX_SHOTS];
+    int targetY[TurnIntent::MAX_SHOTS];
+
+    shots = min(shots, TurnIntent::MAX_SHOTS);
+    random.cells(shots, targetX, targetY);
+
+    for (int i = 0; i < shots; i++)
+    {
+        while (targetX[i] == fromX && targetY[i] == fromY)
+        {
+            random.cells(1, &targetX[i], &targetY[i]);
+        }
+
+        intent.fireAt(targetX[i], targetY[i]);
+    }
+}
+
+/// @brief Picks different cells occupied by robots within the fire range of a cell, at random
+/// @param cells the occupied cells
+/// @param fromX X position the robot fires from, which is never picked
+/// @param fromY Y position the robot fires from, which is never picked
+/// @param shots largest number of cells to pick, at most TurnIntent::MAX_SHOTS
+/// @param draw function returning a random integer in [0, n) for a given n
+/// @param targetX, targetY arrays of shots coordinates to fill
+/// @return number of cells picked, less than shots if fewer robots are in range
+template <typename Draw>
+inline int FiringRobot::pickOccupiedCells(const SpatialIndex &cells, int fromX, int fromY, int shots, Draw draw, int *targetX, int *targetY) const
+{
+    shots = min(shots, TurnIntent::MAX_SHOTS);
+
+    int candidateCount = 0;
+    cells.forEachInDiamond(fromX, fromY, getFireRange(), [&](const SpatialEntry &entry) {
+        candidateCount += entry.posX != fromX || entry.posY != fromY;
+    });
+
+    // The candidates are numbered in the order the index visits them, which only
+    // depends on the game, so the picks are reproducible
+    int picked[TurnIntent::MAX_SHOTS];
+    int pickedCount = min(shots, candidateCount);
+
+    for (int i = 0; i < pickedCount; i++)
+    {
+        bool isPickedBefore = true;
+
+        while (isPickedBefore)
+        {
+            picked[i] = candidateCount <= shots ? i : draw(candidateCount);
+            isPickedBefore = find(picked, picked + i, picked[i]) != picked + i;
+        }
+    }
+
+    int candidate = 0;
+    cells.forEachInDiamond(fromX, fromY, getFireRange(), [&](const SpatialEntry &entry) {
+        if (entry.posX == fromX && entry.posY == fromY)
+            return;
+
+        for (int i = 0; i < pickedCount; i++)
+        {
+            if (picked[i] == candidate)
+            {
+                targetX[i] = entry.posX;
+                targetY[i] = entry.posY;
+            }
+        }
+
+        candidate++;
+    });
+
+    return pickedCount;
+}
+
+/// @brief Picks cells occupied by robots within the fire range to fire at, when the
+/// game plays with targeted fire
+/// @param targetX, targetY arrays of shots coordinates to fill
+/// @param shots largest number of cells to pick
+/// @return number of cells picked, 0 without targeted fire
+inline int FiringRobot::aimAtRobots(int *targetX, int *targetY, int shots) const
+{
+    if (!isTargetedFire || occupiedCells == nullptr)
+    {
+        return 0;
+    }
+
+    return pickOccupiedCells(*occupiedCells, getPositionX(), getPositionY(), shots,
+                             [](int count) { return RNG::integer(0, count - 1); }, targetX, targetY);
+}
+
+/// @brief Aims shots in a simultaneous turn at cells occupied by robots within the fire
+/// range at the start of the turn, when the game plays with targeted fire
+/// @param view the board at the start of the turn
+/// @param random random number generator of the robot
+/// @param intent receives the shots
+/// @param fromX X position the robot fires from, which is never fired at
+/// @param fromY Y position the robot fires from, which is never fired at
+/// @param shots largest number of shots
+/// @return number of shots aimed, 0 without targeted fire
+inline int FiringRobot::aimAtRobots(const TurnView &view, IntentRandom &random, TurnIntent &intent, int fromX, int fromY, int shots) const
+{
+    if (!isTargetedFire || view.getOccupiedCells() == nullptr)
+    {
+        return 0;
+    }
+
+    int targetX[TurnIntent::MAX_SHOTS];
+    int targetY[TurnIntent::MAX_SHOTS];
+
+    int aimedCount = pickOccupiedCells(*view.getOccupiedCells(), fromX, fromY, shots,
+                                       [&](int count) { return random.integer(0, count - 1); }, targetX, targetY);
+
+    for (int i = 0; i < aimedCount; i++)
+    {
+        intent.fireAt(targetX[i], targetY[i]);
+    }
+
+    return aimedCount;
+}
+
 /// @return >= 0 : indicates the fire range value.
 /// @return == -1 : indicates an unlimited fire range value
 inline int FiringRobot::getFireRange() const
@@ -251,6 +533,9 @@ private:
 public:
     bool move(int relativeX, int relativeY);
 
+    int findNearestRobots(int count, SpatialEntry *found) const;
+    bool stepTowardNearest(const SpatialIndex *cells, int fromX, int fromY, int &relativeX, int &relativeY) const;
+
     int getMoveRange() const;
 };
 
@@ -277,10 +562,13 @@ inline bool MovingRobot::move(int relativeX, int relativeY)
         throw PositionOutsideOfBoard();
     }
 
-    if (this->canTrample() == false) {
-        for (int i = 0; i < Robot::robotDeque.size(); i++)
+    // a cell that is clear in the bitboard cannot block the move
+    if (this->canTrample() == false && (occupiedBits == nullptr || occupiedBits->test(positionX, positionY))) {
+        Deque<Robot *> &robots = Robot::robotDeque;
+
+        for (int i = 0; i < robots.size(); i++)
         {
-            if (Robot::robotDeque[i]->getPositionX() == positionX && Robot::robotDeque[i]->getPositionY() == positionY)
+            if (robots[i]->getPositionX() == positionX && robots[i]->getPositionY() == positionY)
             {
                 return false;
             }
@@ -289,12 +577,64 @@ inline bool MovingRobot::move(int relativeX, int relativeY)
 
     Log::move(this->getName(), positionX, positionY);
 
+    if (occupiedCells != nullptr)
+    {
+        occupiedCells->move(this->getPositionX(), this->getPositionY(), positionX, positionY, this->getId());
+    }
+
+    // the cell left stays set, since another robot may still stand on it
+    if (occupiedBits != nullptr)
+    {
+        occupiedBits->set(positionX, positionY);
+    }
+
     this->updatePositionX(positionX);
     this->updatePositionY(positionY);
 
     return true;
 }
 
+/// @brief Finds the other robots nearest to this robot, counting the moves needed to
+/// reach them. Only possible while the game keeps an index of occupied cells
+/// @param count largest number of robots to find
+/// @param found receives the robots found, nearest first
+/// @return number of robots found, 0 if the game keeps no index of occupied cells
+inline int MovingRobot::findNearestRobots(int count, SpatialEntry *found) const
+{
+    if (occupiedCells == nullptr)
+    {
+        return 0;
+    }
+
+    return occupiedCells->findNearest(getPositionX(), getPositionY(), count, getId(), found);
+}
+
+/// @brief Works out the move one cell toward the nearest other robot, when the game plays with hunting
+/// @param cells the occupied cells to search, nullptr if the game keeps none
+/// @param fromX X position the robot moves from
+/// @param fromY Y position the robot moves from
+/// @param relativeX receives the relative X position of the move
+/// @param relativeY receives the relative Y position of the move
+/// @return false if the game does not play with hunting or no other robot stands on another cell
+inline bool MovingRobot::stepTowardNearest(const SpatialIndex *cells, int fromX, int fromY, int &relativeX, int &relativeY) const
+{
+    if (!isHunting || cells == nullptr)
+    {
+        return false;
+    }
+
+    SpatialEntry nearest;
+    if (cells->findNearest(fromX, fromY, 1, getId(), &nearest) == 0)
+    {
+        return false;
+    }
+
+    relativeX = (nearest.posX > fromX) - (nearest.posX < fromX);
+    relativeY = (nearest.posY > fromY) - (nearest.posY < fromY);
+
+    return relativeX != 0 || relativeY != 0;
+}
+
 inline int MovingRobot::getMoveRange() const
 {
     return this->moveRange;
@@ -310,43 +650,52 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
 inline void Nemesis::executeTurn()
 {
-    int relativeX = RNG::integer(-getPositionX(), Board::getWidth() - getPositionX() - 1);
-    int relativeY = RNG::integer(-getPositionY(), Board::getHeight() - getPositionY() - 1);
+    int positionX;
+    int positionY;
+    RNG::cells(1, &positionX, &positionY);
 
-    // Moving to a random cell on the board
-    move(relativeX, relativeY);
+    // Moving to a random cell on the board (staying put if the current cell was picked)
+    if (positionX != getPositionX() || positionY != getPositionY())
+    {
+        move(positionX - getPositionX(), positionY - getPositionY());
+    }
 
     trample(); // tramples any robot that is occupying the same position
 
     // Fire 3 times at random positions on the board
-    int shotsLeft = 3;
-    while (shotsLeft > 0)
+    int targetX[3];
+    int targetY[3];
+    aimAnywhere(targetX, targetY, 3);
+
+    for (int i = 0; i < 3; i++)
     {
-        relativeX = RNG::integer(-getPositionX(), Board::getWidth() - getPositionX() - 1);
-        relativeY = RNG::integer(-getPositionY(), Board::getHeight() - getPositionY() - 1);
+        fire(targetX[i] - getPositionX(), targetY[i] - getPositionY());
+    }
 
-        try
-        {
-            fire(relativeX, relativeY);
-        }
-        catch (FiringRobot::AttemptToShootSelf)
-        {
-            continue;
-        }
-        catch (Robot::PositionOutsideOfBoard)
-        {
-            continue;
-        }
+    setNextTurn(getNextTurn() + 1);
+}
 
-        shotsLeft--;
+inline void Nemesis::decideTurn(const TurnView &, IntentRandom &random, TurnIntent &intent)
+{
+    // Moving to a random cell on the board (staying put if the current cell was picked)
+    int positionX;
+    int positionY;
+    random.cells(1, &positionX, &positionY);
+
+    if (positionX != getPositionX() || positionY != getPositionY())
+    {
+        intent.moveTo(positionX, positionY);
     }
 
-    setNextTurn(getNextTurn() + 1);
+    intent.isTrampling = true;
+
+    aimAnywhere(random, intent, positionX, positionY, 3);
 }
 
 /// @brief Nemesis does not evolve into anything so this function will not do anything
@@ -365,6 +714,7 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
@@ -373,23 +723,12 @@ inline void UltimateRobot::executeTurn()
     Deque<Cell> scannedCells;
 
     // Looking at all adjacent cells
-    for (int i = -1; i <= 1; i++)
-    {
-        for (int j = -1; j <= 1; j++)
-        {
-            if (i == 0 && j == 0)
-                continue;
-
-            scannedCells.push_back(Cell());
+    Cell cells[8];
+    int cellCount = lookAround(cells);
 
-            scannedCells.back() = look(i, j);
-
-            if (!scannedCells.back().isValid)
-            {
-                scannedCells.pop_back();
-                continue;
-            }
-        }
+    for (int i = 0; i < cellCount; i++)
+    {
+        scannedCells.push_back(cells[i]);
     }
 
     // Moving to a random cell if any are valid
@@ -403,29 +742,39 @@ inline void UltimateRobot::executeTurn()
     }
 
     // Fire 3 times at random positions on the board
-    int shotsLeft = 3;
-    while (shotsLeft > 0)
+    int targetX[3];
+    int targetY[3];
+    aimAnywhere(targetX, targetY, 3);
+
+    for (int i = 0; i < 3; i++)
     {
-        int relativeX = RNG::integer(-getPositionX(), Board::getWidth() - getPositionX() - 1);
-        int relativeY = RNG::integer(-getPositionY(), Board::getHeight() - getPositionY() - 1);
+        fire(targetX[i] - getPositionX(), targetY[i] - getPositionY());
+    }
 
-        try
-        {
-            fire(relativeX, relativeY);
-        }
-        catch (FiringRobot::AttemptToShootSelf)
-        {
-            continue;
-        }
-        catch (Robot::PositionOutsideOfBoard)
-        {
-            continue;
-        }
+    setNextTurn(getNextTurn() + 1);
+}
 
-        shotsLeft--;
+inline void UltimateRobot::decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent)
+{
+    Cell cells[8];
+    int cellCount = lookAround(view, intent, cells);
+
+    int positionX = getPositionX();
+    int positionY = getPositionY();
+
+    // Moving to a random cell if any are valid, trampling whatever is there
+    if (cellCount != 0)
+    {
+        int cellIndex = random.integer(0, cellCount - 1);
+
+        positionX += cells[cellIndex].relativeX;
+        positionY += cells[cellIndex].relativeY;
+
+        intent.moveTo(positionX, positionY);
+        intent.isTrampling = true;
     }
 
-    setNextTurn(getNextTurn() + 1);
+    aimAnywhere(random, intent, positionX, positionY, 3);
 }
 
 inline void UltimateRobot::evolve()
@@ -434,6 +783,8 @@ inline void UltimateRobot::evolve()
     robotDeque.push_front(new Nemesis(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "Nemesis");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "Nemesis"));
 }
 
 
@@ -447,6 +798,7 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
@@ -456,27 +808,16 @@ inline void TerminatorRoboCop::executeTurn()
     int enemyIndex = -1; // Index of found enemy position
 
     // Looking at all adjacent cells
-    for (int i = -1; i <= 1; i++)
-    {
-        for (int j = -1; j <= 1; j++)
-        {
-            if (i == 0 && j == 0)
-                continue;
+    Cell cells[8];
+    int cellCount = lookAround(cells);
 
-            scannedCells.push_back(Cell());
-
-            scannedCells.back() = look(i, j);
-
-            if (!scannedCells.back().isValid)
-            {
-                scannedCells.pop_back();
-                continue;
-            }
+    for (int i = 0; i < cellCount; i++)
+    {
+        scannedCells.push_back(cells[i]);
 
-            if (scannedCells.back().occupant != nullptr)
-            {
-                enemyIndex = scannedCells.size() - 1;
-            }
+        if (cells[i].occupant != nullptr)
+        {
+            enemyIndex = scannedCells.size() - 1;
         }
     }
 
@@ -486,10 +827,17 @@ inline void TerminatorRoboCop::executeTurn()
         move(scannedCells[enemyIndex].relativeX, scannedCells[enemyIndex].relativeY);
         trample();
     }
-    // If no enemy is found, move to a random cell if any are valid
+    // If no enemy is found, move toward the nearest robot when hunting, otherwise to a random cell if any are valid
     else
     {
-        if (scannedCells.size() != 0)
+        int relativeX;
+        int relativeY;
+
+        if (stepTowardNearest(occupiedCells, getPositionX(), getPositionY(), relativeX, relativeY))
+        {
+            move(relativeX, relativeY);
+        }
+        else if (scannedCells.size() != 0)
         {
             int cellIndex = RNG::integer(0, scannedCells.size() - 1);
 
@@ -497,8 +845,16 @@ inline void TerminatorRoboCop::executeTurn()
         }
     }
 
-    // Fire 3 times at random positions
-    int shotsLeft = 3;
+    // Fire 3 times, at robots in range first with targeted fire, otherwise at random positions
+    int targetX[3];
+    int targetY[3];
+    int shotsLeft = 3 - aimAtRobots(targetX, targetY, 3);
+
+    for (int i = 0; i < 3 - shotsLeft; i++)
+    {
+        fire(targetX[i] - getPositionX(), targetY[i] - getPositionY());
+    }
+
     while (shotsLeft > 0)
     {
         int offset = getFireRange();
@@ -533,12 +889,58 @@ inline void TerminatorRoboCop::executeTurn()
     }
 }
 
+inline void TerminatorRoboCop::decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent)
+{
+    Cell cells[8];
+    int cellCount = lookAround(view, intent, cells);
+    int enemyIndex = -1; // Index of the last enemy found
+
+    for (int i = 0; i < cellCount; i++)
+    {
+        if (cells[i].occupant != nullptr)
+            enemyIndex = i;
+    }
+
+    int positionX = getPositionX();
+    int positionY = getPositionY();
+
+    int relativeX;
+    int relativeY;
+
+    // If an enemy is found, move to enemy position, otherwise toward the nearest robot
+    // when hunting or to a random cell if any are valid
+    if (enemyIndex == -1 && stepTowardNearest(view.getOccupiedCells(), positionX, positionY, relativeX, relativeY))
+    {
+        positionX += relativeX;
+        positionY += relativeY;
+
+        intent.moveTo(positionX, positionY);
+    }
+    else if (enemyIndex != -1 || cellCount != 0)
+    {
+        int cellIndex = enemyIndex != -1 ? enemyIndex : random.integer(0, cellCount - 1);
+
+        positionX += cells[cellIndex].relativeX;
+        positionY += cells[cellIndex].relativeY;
+
+        intent.moveTo(positionX, positionY);
+        intent.isTrampling = enemyIndex != -1;
+    }
+
+    int aimedCount = aimAtRobots(view, random, intent, positionX, positionY, 3);
+    aimInRange(random, intent, positionX, positionY, 3 - aimedCount);
+
+    intent.evolvesWhenReady = true;
+}
+
 inline void TerminatorRoboCop::evolve()
 {
     robotDeque.pop_front();
     robotDeque.push_front(new UltimateRobot(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "UltimateRobot");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "UltimateRobot"));
 }
 
 class Terminator : public LookingRobot, public MovingRobot, public TramplingRobot
@@ -550,6 +952,7 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
@@ -559,27 +962,16 @@ inline void Terminator::executeTurn()
     int enemyIndex = -1; // Index of found enemy position
 
     // Looking at all adjacent cells
-    for (int i = -1; i <= 1; i++)
-    {
-        for (int j = -1; j <= 1; j++)
-        {
-            if (i == 0 && j == 0)
-                continue;
-
-            scannedCells.push_back(Cell());
+    Cell cells[8];
+    int cellCount = lookAround(cells);
 
-            scannedCells.back() = look(i, j);
-
-            if (!scannedCells.back().isValid)
-            {
-                scannedCells.pop_back();
-                continue;
-            }
+    for (int i = 0; i < cellCount; i++)
+    {
+        scannedCells.push_back(cells[i]);
 
-            if (scannedCells.back().occupant != nullptr)
-            {
-                enemyIndex = scannedCells.size() - 1;
-            }
+        if (cells[i].occupant != nullptr)
+        {
+            enemyIndex = scannedCells.size() - 1;
         }
     }
 
@@ -589,10 +981,17 @@ inline void Terminator::executeTurn()
         move(scannedCells[enemyIndex].relativeX, scannedCells[enemyIndex].relativeY);
         trample();
     }
-    // If no enemy is found, move to a random cell if any are valid
+    // If no enemy is found, move toward the nearest robot when hunting, otherwise to a random cell if any are valid
     else
     {
-        if (scannedCells.size() != 0)
+        int relativeX;
+        int relativeY;
+
+        if (stepTowardNearest(occupiedCells, getPositionX(), getPositionY(), relativeX, relativeY))
+        {
+            move(relativeX, relativeY);
+        }
+        else if (scannedCells.size() != 0)
         {
             int cellIndex = RNG::integer(0, scannedCells.size() - 1);
 
@@ -608,12 +1007,46 @@ inline void Terminator::executeTurn()
     }
 }
 
+inline void Terminator::decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent)
+{
+    Cell cells[8];
+    int cellCount = lookAround(view, intent, cells);
+    int enemyIndex = -1; // Index of the last enemy found
+
+    for (int i = 0; i < cellCount; i++)
+    {
+        if (cells[i].occupant != nullptr)
+            enemyIndex = i;
+    }
+
+    int relativeX;
+    int relativeY;
+
+    // If an enemy is found, move to enemy position, otherwise toward the nearest robot
+    // when hunting or to a random cell if any are valid
+    if (enemyIndex == -1 && stepTowardNearest(view.getOccupiedCells(), getPositionX(), getPositionY(), relativeX, relativeY))
+    {
+        intent.moveTo(getPositionX() + relativeX, getPositionY() + relativeY);
+    }
+    else if (enemyIndex != -1 || cellCount != 0)
+    {
+        int cellIndex = enemyIndex != -1 ? enemyIndex : random.integer(0, cellCount - 1);
+
+        intent.moveTo(getPositionX() + cells[cellIndex].relativeX, getPositionY() + cells[cellIndex].relativeY);
+        intent.isTrampling = enemyIndex != -1;
+    }
+
+    intent.evolvesWhenReady = true;
+}
+
 inline void Terminator::evolve()
 {
     robotDeque.pop_front();
     robotDeque.push_front(new TerminatorRoboCop(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "TerminatorRoboCop");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "TerminatorRoboCop"));
 }
 
 class RoboCop : public LookingRobot, public MovingRobot, public FiringRobot
@@ -626,6 +1059,7 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
@@ -633,23 +1067,15 @@ inline void RoboCop::executeTurn()
 {
     Deque<Cell> scannedCells;
 
-    // Looking at all adjacent cells
-    for (int i = -1; i <= 1; i++)
+    // Looking at all adjacent cells, keeping the empty ones
+    Cell cells[8];
+    int cellCount = lookAround(cells);
+
+    for (int i = 0; i < cellCount; i++)
     {
-        for (int j = -1; j <= 1; j++)
+        if (cells[i].occupant == nullptr)
         {
-            if (i == 0 && j == 0)
-                continue;
-
-            scannedCells.push_back(Cell());
-
-            scannedCells.back() = look(i, j);
-
-            if (!scannedCells.back().isValid || scannedCells.back().occupant != nullptr)
-            {
-                scannedCells.pop_back();
-                continue;
-            }
+            scannedCells.push_back(cells[i]);
         }
     }
 
@@ -661,8 +1087,16 @@ inline void RoboCop::executeTurn()
         move(scannedCells[cellIndex].relativeX, scannedCells[cellIndex].relativeY);
     }
 
-    // Fire 3 times at random positions
-    int shotsLeft = 3;
+    // Fire 3 times, at robots in range first with targeted fire, otherwise at random positions
+    int targetX[3];
+    int targetY[3];
+    int shotsLeft = 3 - aimAtRobots(targetX, targetY, 3);
+
+    for (int i = 0; i < 3 - shotsLeft; i++)
+    {
+        fire(targetX[i] - getPositionX(), targetY[i] - getPositionY());
+    }
+
     while (shotsLeft > 0)
     {
         int offset = getFireRange();
@@ -697,6 +1131,39 @@ inline void RoboCop::executeTurn()
     }
 }
 
+inline void RoboCop::decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent)
+{
+    Cell cells[8];
+    int cellCount = lookAround(view, intent, cells);
+
+    // Only empty cells can be moved to
+    int emptyCount = 0;
+    for (int i = 0; i < cellCount; i++)
+    {
+        if (cells[i].occupant == nullptr)
+            cells[emptyCount++] = cells[i];
+    }
+
+    int positionX = getPositionX();
+    int positionY = getPositionY();
+
+    // Moving to a random cell if any are valid
+    if (emptyCount != 0)
+    {
+        int cellIndex = random.integer(0, emptyCount - 1);
+
+        positionX += cells[cellIndex].relativeX;
+        positionY += cells[cellIndex].relativeY;
+
+        intent.moveTo(positionX, positionY);
+    }
+
+    int aimedCount = aimAtRobots(view, random, intent, positionX, positionY, 3);
+    aimInRange(random, intent, positionX, positionY, 3 - aimedCount);
+
+    intent.evolvesWhenReady = true;
+}
+
 /// @brief Evolves this RoboCop into a TerminatorRoboCop
 inline void RoboCop::evolve()
 {
@@ -704,6 +1171,8 @@ inline void RoboCop::evolve()
     robotDeque.push_front(new TerminatorRoboCop(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "TerminatorRoboCop");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "TerminatorRoboCop"));
 }
 
 class RoboTank : public FiringRobot
@@ -716,33 +1185,18 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
 inline void RoboTank::executeTurn()
 {
     // Shooting a random position on the board
-    bool hasShot = false;
-    while (!hasShot)
-    {
-        int relativeX = RNG::integer(-getPositionX(), Board::getWidth() - getPositionX() - 1);
-        int relativeY = RNG::integer(-getPositionY(), Board::getHeight() - getPositionY() - 1);
+    int targetX;
+    int targetY;
+    aimAnywhere(&targetX, &targetY, 1);
 
-        try
-        {
-            fire(relativeX, relativeY);
-        }
-        catch (FiringRobot::AttemptToShootSelf)
-        {
-            continue;
-        }
-        catch (Robot::PositionOutsideOfBoard)
-        {
-            continue;
-        }
-
-        hasShot = true;
-    }
+    fire(targetX - getPositionX(), targetY - getPositionY());
 
     setNextTurn(getNextTurn() + 1);
 
@@ -752,12 +1206,21 @@ inline void RoboTank::executeTurn()
     }
 }
 
+inline void RoboTank::decideTurn(const TurnView &, IntentRandom &random, TurnIntent &intent)
+{
+    aimAnywhere(random, intent, getPositionX(), getPositionY(), 1);
+
+    intent.evolvesWhenReady = true;
+}
+
 inline void RoboTank::evolve()
 {
     robotDeque.pop_front();
     robotDeque.push_front(new UltimateRobot(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "UltimateRobot");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "UltimateRobot"));
 }
 
 class Madbot : public FiringRobot
@@ -770,6 +1233,7 @@ public:
     };
 
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
@@ -806,12 +1270,31 @@ inline void Madbot::executeTurn()
     }
 }
 
+inline void Madbot::decideTurn(const TurnView &, IntentRandom &random, TurnIntent &intent)
+{
+    // Fire at a random valid adjacent position
+    while (intent.shotCount == 0)
+    {
+        int relativeX = random.integer(-1, 1);
+        int relativeY = random.integer(-1, 1);
+
+        if ((relativeX != 0 || relativeY != 0) && TurnView::isInside(getPositionX() + relativeX, getPositionY() + relativeY))
+        {
+            intent.fireAt(getPositionX() + relativeX, getPositionY() + relativeY);
+        }
+    }
+
+    intent.evolvesWhenReady = true;
+}
+
 inline void Madbot::evolve()
 {
     robotDeque.pop_front();
     robotDeque.push_front(new RoboTank(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "RoboTank");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "RoboTank"));
 }
 
 class BlueThunder : public FiringRobot
@@ -829,10 +1312,33 @@ public:
         setFireRange(1);
     };
 
+    int getFirePositionX() const;
+    int getFirePositionY() const;
+
+    /// @brief sets the relative position the next shot is fired at, used when restoring a saved game
+    void setFirePosition(int firePositionX, int firePositionY);
+
     void executeTurn();
+    void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent);
     void evolve();
 };
 
+inline int BlueThunder::getFirePositionX() const
+{
+    return firePositionX;
+}
+
+inline int BlueThunder::getFirePositionY() const
+{
+    return firePositionY;
+}
+
+inline void BlueThunder::setFirePosition(int firePositionX, int firePositionY)
+{
+    this->firePositionX = firePositionX;
+    this->firePositionY = firePositionY;
+}
+
 /// @brief Sets the the fire position to the next position in a circular fashion
 inline void BlueThunder::setNextFirePosition()
 {
@@ -874,13 +1380,148 @@ inline void BlueThunder::executeTurn()
     }
 }
 
+inline void BlueThunder::decideTurn(const TurnView &, IntentRandom &, TurnIntent &intent)
+{
+    // Fires at the next valid position in a clockwise fashion
+    while (intent.shotCount == 0)
+    {
+        if (TurnView::isInside(getPositionX() + firePositionX, getPositionY() + firePositionY))
+        {
+            intent.fireAt(getPositionX() + firePositionX, getPositionY() + firePositionY);
+        }
+
+        setNextFirePosition();
+    }
+
+    intent.evolvesWhenReady = true;
+}
+
 inline void BlueThunder::evolve()
 {
     robotDeque.pop_front();
     robotDeque.push_front(new Madbot(getName(), getPositionX(), getPositionY()));
     robotDeque.front()->setNextTurn(getNextTurn());
     Log::evolve(getName(), "Madbot");
+    evolveCount++;
+    TRACE_INSTANT("evolve", Tracer::robotArgs(getName(), getType()) + "," + Tracer::stringArg("into", "Madbot"));
 }
 
 
+/*---------------------------------------------*/
+/*                Robot Creation               */
+/*---------------------------------------------*/
+
+/// @brief Every type of robot that can be created
+enum RobotType
+{
+    ROBOCOP,
+    TERMINATOR,
+    TERMINATOR_ROBOCOP,
+    BLUE_THUNDER,
+    MADBOT,
+    ROBOTANK,
+    ULTIMATE_ROBOT,
+    NEMESIS,
+    INVALID_ROBOT_TYPE
+};
+
+/// @brief Looks up the robot type with the given name
+/// @details The length of the name together with its first character is
+///          unique for every robot type, so a type is identified with a
+///          switch and a single string compare.
+/// @param name name of the robot type, e.g. "RoboCop"
+/// @return the robot type, INVALID_ROBOT_TYPE if the name is not a robot type
+inline RobotType robotTypeFromName(string_view name)
+{
+    RobotType type = INVALID_ROBOT_TYPE;
+    const char *expectedName = "";
+
+    switch (name.size())
+    {
+    case 6:
+        type = MADBOT;
+        expectedName = "Madbot";
+        break;
+    case 7:
+        if (name[0] == 'R')
+        {
+            type = ROBOCOP;
+            expectedName = "RoboCop";
+        }
+        else
+        {
+            type = NEMESIS;
+            expectedName = "Nemesis";
+        }
+        break;
+    case 8:
+        type = ROBOTANK;
+        expectedName = "RoboTank";
+        break;
+    case 10:
+        type = TERMINATOR;
+        expectedName = "Terminator";
+        break;
+    case 11:
+        type = BLUE_THUNDER;
+        expectedName = "BlueThunder";
+        break;
+    case 13:
+        type = ULTIMATE_ROBOT;
+        expectedName = "UltimateRobot";
+        break;
+    case 17:
+        type = TERMINATOR_ROBOCOP;
+        expectedName = "TerminatorRoboCop";
+        break;
+    default:
+        return INVALID_ROBOT_TYPE;
+    }
+
+    return name == expectedName ? type : INVALID_ROBOT_TYPE;
+}
+
+/// @brief Returns the name of a robot type
+/// @param type type of the robot
+/// @return the name, e.g. "RoboCop", or "" if type is INVALID_ROBOT_TYPE
+inline const char *robotTypeName(RobotType type)
+{
+    static const char *const ROBOT_TYPE_NAMES[INVALID_ROBOT_TYPE] = {
+        "RoboCop", "Terminator", "TerminatorRoboCop", "BlueThunder",
+        "Madbot", "RoboTank", "UltimateRobot", "Nemesis"};
+
+    return type >= 0 && type < INVALID_ROBOT_TYPE ? ROBOT_TYPE_NAMES[type] : "";
+}
+
+/// @brief Creates a new robot of the given type
+/// @param type type of the robot
+/// @param name name of the robot
+/// @param posX X position of the robot
+/// @param posY Y position of the robot
+/// @return pointer to the new robot, nullptr if type is INVALID_ROBOT_TYPE
+inline Robot *createRobot(RobotType type, const string &name, int posX, int posY)
+{
+    switch (type)
+    {
+    case ROBOCOP:
+        return new RoboCop(name, posX, posY);
+    case TERMINATOR:
+        return new Terminator(name, posX, posY);
+    case TERMINATOR_ROBOCOP:
+        return new TerminatorRoboCop(name, posX, posY);
+    case BLUE_THUNDER:
+        return new BlueThunder(name, posX, posY);
+    case MADBOT:
+        return new Madbot(name, posX, posY);
+    case ROBOTANK:
+        return new RoboTank(name, posX, posY);
+    case ULTIMATE_ROBOT:
+        return new UltimateRobot(name, posX, posY);
+    case NEMESIS:
+        return new Nemesis(name, posX, posY);
+    default:
+        return nullptr;
+    }
+}
+
 #endif
\ No newline at end of file
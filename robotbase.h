@@ -10,10 +10,17 @@
 #ifndef ROBOTBASE_H
 #define ROBOTBASE_H
 
+#include "bitboard.h"
 #include "deque.h"
+#include "spatial.h"
+#include "tracer.h"
 
 using namespace std;
 
+class TurnView;
+class IntentRandom;
+struct TurnIntent;
+
 /// @brief The base class of every robot. Contains variables and functions that every robot should contain
 class Robot
 {
@@ -21,6 +28,14 @@ private:
     string name;
     string type;
 
+    /// @brief Number that identifies this robot object, unique among the robots of its game.
+    /// Saved with the game, so a resumed game gives every robot the same id
+    int id;
+
+    /// @brief The id given to the next robot that is created on this thread. Every game
+    /// starts counting from 0, so the ids only depend on the game
+    static thread_local int nextId;
+
     /// @brief The next turn number this robot should execute it's actions
     int nextTurn = 1;
 
@@ -46,19 +61,44 @@ public:
     {
     };
 
+    // The robot queues & counters belong to the game being played on the current thread,
+    // so that several games can be played at once on separate threads (see batch.h)
+
     /// @brief Stores pointers to all robot objects that are still alive
-    static Deque<Robot *> robotDeque; // static variable declaration
+    static thread_local Deque<Robot *> robotDeque; // static variable declaration
 
     /// @brief Stores pointers to al robot objects that are dead and waiting to be revived
-    static Deque<Robot *> reviveDeque; // static variable declaration
+    static thread_local Deque<Robot *> reviveDeque; // static variable declaration
+
+    /// @brief Number of kills & evolutions on this thread since the program started. Comparing
+    /// them before and after a turn tells whether anything was killed or evolved during it
+    static thread_local long long killCount;
+    static thread_local long long evolveCount;
+
+    /// @brief Optional behaviours the game on this thread plays with, see
+    /// Game::setTargetedFire() & Game::setHunting()
+    static thread_local bool isTargetedFire;
+    static thread_local bool isHunting;
+
+    /// @brief Cells occupied by the robots of the game on this thread, indexed by robot id.
+    /// Only kept while the game plays with targeted fire or hunting, nullptr otherwise
+    static thread_local SpatialIndex *occupiedCells;
+
+    /// @brief Cells that may hold a robot of the game on this thread: the cell of every robot
+    /// is set, so a clear cell is certainly empty. Cells are set as robots move onto them
+    /// and only cleared when it is rebuilt at the start of every turn. nullptr on boards
+    /// too large to keep it (see Game::MAX_BITBOARD_CELLS)
+    static thread_local Bitboard *occupiedBits;
 
     Robot(string name, int posX, int posY);
+    virtual ~Robot();
 
     /*---------------------------------------------*/
     /*                 Accessors                   */
     /*---------------------------------------------*/
 
     string getName() const;
+    int getId() const;
     int getPositionX() const;
     int getPositionY() const;
     int getKillsToNextEvolve() const;
@@ -85,6 +125,21 @@ public:
     /// @brief reduces the number of lives this robot has by one
     void minusOneLife();
 
+    /// @brief sets the number of lives directly, used when restoring a saved game
+    void setLives(int lives);
+
+    /// @brief sets the number of kills needed to evolve directly, used when restoring a saved game
+    void setKillsToNextEvolve(int killsToNextEvolve);
+
+    /// @brief sets the id directly, used when restoring a saved game
+    void setId(int id);
+
+    /// @brief The id the next robot created on this thread gets
+    static int getNextId();
+
+    /// @brief Sets the id the next robot created on this thread gets, when a game is started or restored
+    static void setNextId(int id);
+
     /// @brief  decrement this robot's killsToNextEvolve by killsToAdd
     /// @param killsToAdd number of kills
     void addKill(int killsToAdd);
@@ -96,20 +151,44 @@ public:
     /// @param robotToKill pointer to robotToKill
     virtual void kill(Robot *robotToKill);
 
+    /// @brief make this robot kill robotToKill, but leave robotToKill in the robotDeque
+    /// for the caller to remove. Used when many robots are removed from the robotDeque at once
+    /// @param robotToKill pointer to robotToKill
+    void killWithoutRemoving(Robot *robotToKill);
+
     /// @brief Executes all the necessary actions this robot does in a turn
     virtual void executeTurn() = 0;
 
+    /// @brief Decides the actions this robot does in a simultaneous turn, without
+    /// changing anything but this robot's own private state. May be called on any thread
+    /// @param view the board at the start of the turn
+    /// @param random this robot's random number generator for the turn
+    /// @param intent receives the decided actions
+    virtual void decideTurn(const TurnView &view, IntentRandom &random, TurnIntent &intent) = 0;
+
     virtual void evolve() = 0;
 };
 
-Deque<Robot *> Robot::robotDeque;
-Deque<Robot *> Robot::reviveDeque;
+thread_local Deque<Robot *> Robot::robotDeque;
+thread_local Deque<Robot *> Robot::reviveDeque;
+thread_local int Robot::nextId = 0;
+thread_local long long Robot::killCount = 0;
+thread_local long long Robot::evolveCount = 0;
+thread_local bool Robot::isTargetedFire = false;
+thread_local bool Robot::isHunting = false;
+thread_local SpatialIndex *Robot::occupiedCells = nullptr;
+thread_local Bitboard *Robot::occupiedBits = nullptr;
 
 inline Robot::Robot(string name, int posX, int posY)
 {
     this->name = name;
     this->posX = posX;
     this->posY = posY;
+    this->id = nextId++;
+}
+
+inline Robot::~Robot()
+{
 }
 
 inline string Robot::getName() const
@@ -117,6 +196,26 @@ inline string Robot::getName() const
     return this->name;
 }
 
+inline int Robot::getId() const
+{
+    return this->id;
+}
+
+inline void Robot::setId(int id)
+{
+    this->id = id;
+}
+
+inline int Robot::getNextId()
+{
+    return nextId;
+}
+
+inline void Robot::setNextId(int id)
+{
+    nextId = id;
+}
+
 inline int Robot::getPositionX() const
 {
     return this->posX;
@@ -200,6 +299,16 @@ inline void Robot::minusOneLife()
         this->lives--;
 }
 
+inline void Robot::setLives(int lives)
+{
+    this->lives = lives;
+}
+
+inline void Robot::setKillsToNextEvolve(int killsToNextEvolve)
+{
+    this->killsToNextEvolve = killsToNextEvolve;
+}
+
 inline void Robot::addKill(int killsToAdd)
 {
     if (killsToAdd < 0)
@@ -221,27 +330,40 @@ inline void Robot::setReadyToEvolve()
 
 inline void Robot::kill(Robot *robotToKill)
 {
-    // subtract one life from robotToKill
-    robotToKill->minusOneLife();
-    
-    this->addKill(1);
-
+    killWithoutRemoving(robotToKill);
 
+    Deque<Robot *> &robots = Robot::robotDeque;
     int IndexOfRobotToKill = 0;
 
     // searching for the index of robotToKill in the robotDeque
-    while (Robot::robotDeque[IndexOfRobotToKill] != robotToKill)
+    while (robots[IndexOfRobotToKill] != robotToKill)
     {
         IndexOfRobotToKill++;
     }
 
+    robots.erase(IndexOfRobotToKill);
+}
+
+inline void Robot::killWithoutRemoving(Robot *robotToKill)
+{
+    // subtract one life from robotToKill
+    robotToKill->minusOneLife();
+    killCount++;
+
+    TRACE_INSTANT("kill", Tracer::stringArg("killer", this->getName()) + "," + Tracer::stringArg("victim", robotToKill->getName()) +
+                              ",\"livesLeft\":" + to_string(robotToKill->getLives()));
+    
+    this->addKill(1);
+
+    if (occupiedCells != nullptr)
+    {
+        occupiedCells->remove(robotToKill->getPositionX(), robotToKill->getPositionY(), robotToKill->getId());
+    }
 
     if (robotToKill->getLives() > 0)
     {
         Robot::reviveDeque.push_back(robotToKill);
     }
-
-    Robot::robotDeque.erase(IndexOfRobotToKill);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+/*
+ *
+ * This file contains the binary scenario format, which stores the same data as
+ * a text config file in a form that can be used straight from memory
+ *
+ * --- File Layout ---
+ *
+ *   [Header]       magic "RBSC", version, board width & height, turn limit,
+ *                  number of robots & size of the name table (32 bytes)
+ *   [RobotRecord]  one 16 byte record per robot, in config file order
+ *   [Name table]   every distinct robot name, stored once, back to back
+ *
+ * All values are stored in the byte order of the machine that wrote the file.
+ * Positions equal to ConfigParser::RANDOM_POSITION are drawn when the game
+ * starts, exactly like "random" positions in a text config.
+ *
+ * --- Code Summary ---
+ * ScenarioWriter converts a text config into the binary format, interning the
+ * robot names so that repeated names only take up space once.
+ *
+ * Scenario reads a binary scenario straight out of a memory mapped file: it
+ * only checks that the header matches the size of the file, after which the
+ * records & names are used directly from the mapped memory without any parsing.
+ *
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "config.h"
+
+using namespace std;
+
+/// @brief Header at the start of every binary scenario file
+struct ScenarioHeader
+{
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t turnLimit;
+    int32_t robotCount;
+    uint32_t nameTableSize;
+    uint32_t reserved;
+};
+
+/// @brief A robot as stored in a binary scenario file
+struct RobotRecord
+{
+    int32_t posX;
+    int32_t posY;
+
+    /// @brief position of the robot's name in the name table
+    uint32_t nameOffset;
+    uint16_t nameLength;
+
+    /// @brief RobotType of the robot
+    uint8_t type;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(ScenarioHeader) == 32, "ScenarioHeader must not contain padding");
+static_assert(sizeof(RobotRecord) == 16, "RobotRecord must not contain padding");
+
+const char SCENARIO_MAGIC[4] = {'R', 'B', 'S', 'C'};
+const uint32_t SCENARIO_VERSION = 1;
+
+class ScenarioWriter
+{
+public:
+    // Exception for robot names that are too long to be stored in a RobotRecord
+    class NameTooLong
+    {
+    };
+
+    /// @brief Converts a text config into a binary scenario
+    /// @param configText contents of the text config file
+    /// @param output stream the binary scenario is written to (opened in binary mode)
+    /// @exception ConfigParser::ConfigError thrown if the text config is invalid
+    /// @exception NameTooLong thrown if a robot name is longer than 65535 characters
+    static void convert(string_view configText, ostream &output);
+};
+
+inline void ScenarioWriter::convert(string_view configText, ostream &output)
+{
+    ConfigParser parser(configText);
+    parser.parseHeader();
+
+    vector<RobotRecord> records;
+    records.reserve(parser.getRobotCount());
+
+    string nameTable;
+
+    /// @brief offset in the name table of every name that has been stored
+    unordered_map<string_view, uint32_t> nameOffsets;
+
+    ConfigParser::RobotEntry entry;
+    while (parser.nextRobot(entry))
+    {
+        if (entry.name.size() > UINT16_MAX)
+        {
+            throw NameTooLong();
+        }
+
+        auto name = nameOffsets.find(entry.name);
+        if (name == nameOffsets.end())
+        {
+            // entry.name points into configText, which outlives the map
+            name = nameOffsets.insert({entry.name, (uint32_t)nameTable.size()}).first;
+            nameTable += entry.name;
+        }
+
+        RobotRecord record = {};
+        record.posX = entry.posX;
+        record.posY = entry.posY;
+        record.nameOffset = name->second;
+        record.nameLength = (uint16_t)entry.name.size();
+        record.type = (uint8_t)entry.type;
+
+        records.push_back(record);
+    }
+
+    ScenarioHeader header = {};
+    memcpy(header.magic, SCENARIO_MAGIC, sizeof(header.magic));
+    header.version = SCENARIO_VERSION;
+    header.width = parser.getWidth();
+    header.height = parser.getHeight();
+    header.turnLimit = parser.getTurnLimit();
+    header.robotCount = parser.getRobotCount();
+    header.nameTableSize = (uint32_t)nameTable.size();
+
+    output.write((const char *)&header, sizeof(header));
+    output.write((const char *)records.data(), records.size() * sizeof(RobotRecord));
+    output.write(nameTable.data(), nameTable.size());
+}
+
+class Scenario
+{
+private:
+    const ScenarioHeader *header = nullptr;
+    const RobotRecord *records = nullptr;
+    const char *nameTable = nullptr;
+
+public:
+    // Exception for files that are not valid binary scenarios
+    class InvalidScenario
+    {
+    };
+
+    /// @brief Reads a binary scenario from the contents of a mapped file
+    /// @param contents contents of the file, which must stay mapped while the scenario is used
+    /// @exception InvalidScenario thrown if the contents are not a valid binary scenario
+    Scenario(string_view contents);
+
+    /// @brief Checks whether a file starts like a binary scenario
+    /// @param contents contents of the file
+    /// @return true if the file starts with the binary scenario magic
+    static bool isScenario(string_view contents);
+
+    /*---------------------------------------------*/
+    /*                 Accessors                   */
+    /*---------------------------------------------*/
+
+    int getWidth() const;
+    int getHeight() const;
+    int getTurnLimit() const;
+    int getRobotCount() const;
+
+    /// @param i index of the robot
+    /// @return reference to the record of robot i
+    const RobotRecord &getRobot(int i) const;
+
+    /// @param record a record of this scenario
+    /// @return the name of the robot, pointing into the mapped file
+    string_view getName(const RobotRecord &record) const;
+};
+
+inline Scenario::Scenario(string_view contents)
+{
+    if (!isScenario(contents) || contents.size() < sizeof(ScenarioHeader))
+    {
+        throw InvalidScenario();
+    }
+
+    // mmap returns page aligned memory, so the header and the records
+    // behind it are correctly aligned
+    header = (const ScenarioHeader *)contents.data();
+
+    if (header->version != SCENARIO_VERSION || header->width <= 0 || header->height <= 0 ||
+        header->turnLimit < 0 || header->robotCount < 0)
+    {
+        throw InvalidScenario();
+    }
+
+    uint64_t expectedSize = sizeof(ScenarioHeader) + (uint64_t)header->robotCount * sizeof(RobotRecord) + header->nameTableSize;
+
+    if (contents.size() != expectedSize)
+    {
+        throw InvalidScenario();
+    }
+
+    records = (const RobotRecord *)(contents.data() + sizeof(ScenarioHeader));
+    nameTable = (const char *)(records + header->robotCount);
+}
+
+inline bool Scenario::isScenario(string_view contents)
+{
+    return contents.size() >= sizeof(SCENARIO_MAGIC) && memcmp(contents.data(), SCENARIO_MAGIC, sizeof(SCENARIO_MAGIC)) == 0;
+}
+
+inline int Scenario::getWidth() const
+{
+    return header->width;
+}
+
+inline int Scenario::getHeight() const
+{
+    return header->height;
+}
+
+inline int Scenario::getTurnLimit() const
+{
+    return header->turnLimit;
+}
+
+inline int Scenario::getRobotCount() const
+{
+    return header->robotCount;
+}
+
+inline const RobotRecord &Scenario::getRobot(int i) const
+{
+    return records[i];
+}
+
+/// @exception InvalidScenario thrown if the name lies outside of the name table
+inline string_view Scenario::getName(const RobotRecord &record) const
+{
+    if ((uint64_t)record.nameOffset + record.nameLength > header->nameTableSize)
+    {
+        throw InvalidScenario();
+    }
+
+    return string_view(nameTable + record.nameOffset, record.nameLength);
+}
+
+#endif
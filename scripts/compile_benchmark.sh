@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 benchmark.cpp -o "benchmark.out" 2>&1 | tee ./output/benchmark_output.txt || exit
+./benchmark.out
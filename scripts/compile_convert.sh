@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 convert.cpp -o "convert.out" 2>&1 | tee ./output/convert_output.txt || exit
+./convert.out "$@"
@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 generate.cpp -o "generate.out" 2>&1 | tee ./output/generate_output.txt || exit
+./generate.out "$@"
@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 -DPROFILE_TURNS main.cpp -o "main_profile.out" 2>&1 | tee ./output/main_profile_output.txt || exit
+echo "config.txt" | ./main_profile.out
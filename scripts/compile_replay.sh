@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 replay.cpp -o "replay.out" 2>&1 | tee ./output/replay_output.txt || exit
+./replay.out "$@"
@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 tournament.cpp -o "tournament.out" 2>&1 | tee ./output/tournament_output.txt || exit
+./tournament.out "$@"
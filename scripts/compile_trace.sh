@@ -0,0 +1,4 @@
+#!/usr/bin/bash
+
+g++ -O2 -DTRACE_EVENTS main.cpp -o "main_trace.out" 2>&1 | tee ./output/main_trace_output.txt || exit
+echo "config.txt" | ./main_trace.out
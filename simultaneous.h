@@ -0,0 +1,520 @@
+/*
+ *
+ * This file contains the SimultaneousTurn class that plays a turn with the
+ * simultaneous rules, where every robot decides its actions at the same time
+ *
+ * --- Code Summary ---
+ * In a normal turn the robots act one after another, each seeing the board as
+ * the robots before it left it. In a simultaneous turn every robot instead
+ * decides what it does against the board as it was at the start of the turn
+ * (see intent.h), and the decisions are then carried out in this order:
+ *
+ *   1. robots seen by looking robots are logged
+ *   2. moves: where several robots move to the same cell, the robot earliest in
+ *      the robot queue gets it and the others stay where they are
+ *   3. tramples: every trampling robot tramples the robot earliest in the
+ *      robot queue that shares its cell
+ *   4. shots: every shot hits the robot earliest in the robot queue on the
+ *      targeted cell, which is never the robot that fired
+ *   5. evolutions: robots that became ready to evolve during the turn evolve
+ *
+ * Within every step the robots go in robot queue order, and a robot that was
+ * killed in an earlier step takes no further part in the turn.
+ *
+ * The board is split into bands of rows, one per thread. Every band owns the
+ * robots standing in it and works on its own thread:
+ *
+ *   - it builds its own view of the board, holding its robots plus a halo of
+ *     the robots in the row just above & just below it, copied from the
+ *     neighbouring bands. Robots only look at the 8 cells around them, so this
+ *     is all its robots need to decide, and they are decided against it, in
+ *     the order the view stores them (along a Hilbert curve, see intent.h)
+ *   - it settles which robot wins each of its cells that robots move to
+ *   - it sorts the robots standing in it after the moves, so the robots on
+ *     any of its cells can be found with a binary search
+ *
+ * Moves & shots that reach far across the board (Nemesis moves, RoboTank,
+ * UltimateRobot & Nemesis shots) are handled like every other action: each is
+ * sent to the band that owns its target cell. The only work left on one
+ * thread is the coordinated pass that carries out the moves, tramples & shots
+ * in robot queue order & logs them, which is what keeps the rules above
+ * exact. Killed robots stay in the robot queue until the end of the turn and
+ * are then dropped all at once.
+ *
+ * How the board is split never changes which robot sees, wins or hits what,
+ * so the outcome of a turn only depends on the board at its start and the
+ * random number generator, not on the number of threads.
+ *
+ */
+
+#ifndef SIMULTANEOUS_H
+#define SIMULTANEOUS_H
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "board.h"
+#include "intent.h"
+#include "log.h"
+#include "random.h"
+#include "robot.h"
+#include "tracer.h"
+
+using namespace std;
+
+class SimultaneousTurn
+{
+private:
+    /// @brief Rows [top, bottom] of the board and the robots standing in them
+    struct Band
+    {
+        int top = 0;
+        int bottom = 0;
+
+        /// @brief index in robots of every robot in the band at the start of the turn, in robot queue order
+        vector<int> robots;
+
+        /// @brief the robots of the band in its top & bottom row, the halo of the neighbouring bands
+        vector<int> topRow;
+        vector<int> bottomRow;
+
+        /// @brief the robots of the band & its halo at the start of the turn
+        TurnView view;
+
+        /// @brief (target cell, index in robots) of every move into the band
+        vector<pair<long long, int>> moves;
+
+        /// @brief (cell, index in robots) of every acting robot in the band after the moves, sorted
+        /// so that the robots on a cell can be found with a binary search, earliest in the robot queue first
+        vector<pair<long long, int>> cells;
+    };
+
+    /// @brief Number of threads the turn is split across
+    int threadCount = 1;
+
+    vector<Band> bands;
+    int bandHeight = 1;
+
+    /// @brief every robot in the robot queue, in order
+    vector<Robot *> robots;
+
+    /// @brief robots[0, actingCount) act this turn
+    int actingCount = 0;
+
+    /// @brief decision of every acting robot
+    vector<TurnIntent> intents;
+
+    /// @brief true for every acting robot that won the cell it moves to
+    vector<char> hasWonCell;
+
+    /// @brief true for every acting robot that has been killed this turn
+    vector<char> isRemoved;
+
+    /// @brief for every acting robot, the first entry of its band's cells on the cell it
+    /// tramples (slot 0) and on every cell it fires at (slots 1 to MAX_SHOTS), -1 if no robot is there
+    static const int TARGET_SLOTS = 1 + TurnIntent::MAX_SHOTS;
+    vector<int> targets;
+
+    /// @brief Fewest robots worth a band & thread of their own, since starting a thread costs far more than deciding a robot
+    static const int MIN_ROBOTS_PER_THREAD = 256;
+
+    template <typename Job>
+    void runInParallel(int jobCount, Job job);
+
+    int bandOf(int posY) const;
+    void splitBoard();
+    void decideBand(int bandIndex, const TurnStreams &streams, const SpatialIndex *occupiedCells);
+    void moveRobots();
+    void sortCells();
+    void findTargets(int begin, int end);
+    int findTarget(int posX, int posY, int first, int ignoredIndex) const;
+    void removeRobot(int killerIndex, int victimIndex);
+    void trampleRobots();
+    void fireShots();
+    void finishTurn(int turn);
+
+public:
+    /// @param threadCount number of threads the turn is split across, at least 1
+    void setThreadCount(int threadCount);
+
+    /// @brief Plays one turn with the simultaneous rules
+    /// @param turn the turn being played
+    void play(int turn);
+};
+
+inline void SimultaneousTurn::setThreadCount(int threadCount)
+{
+    this->threadCount = max(threadCount, 1);
+}
+
+/// @brief Calls job(i) for every i in [0, jobCount), split into blocks across threads
+template <typename Job>
+inline void SimultaneousTurn::runInParallel(int jobCount, Job job)
+{
+    int blockCount = min(threadCount, jobCount);
+
+    int width = Board::getWidth();
+    int height = Board::getHeight();
+    bool isTargetedFire = Robot::isTargetedFire;
+    bool isHunting = Robot::isHunting;
+
+    auto runBlock = [&](int block) {
+        // the board size & the robots' optional behaviours are kept per thread, and the robots' decisions need them
+        Board::setSize(width, height);
+        Robot::isTargetedFire = isTargetedFire;
+        Robot::isHunting = isHunting;
+
+        for (int i = (long long)jobCount * block / blockCount; i < (long long)jobCount * (block + 1) / blockCount; i++)
+        {
+            job(i);
+        }
+    };
+
+    vector<thread> workers;
+    workers.reserve(max(blockCount - 1, 0));
+
+    // block 0 is run on this thread while the others run
+    for (int block = 1; block < blockCount; block++)
+    {
+        workers.emplace_back(runBlock, block);
+    }
+
+    if (blockCount > 0)
+    {
+        runBlock(0);
+    }
+
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+inline void SimultaneousTurn::play(int turn)
+{
+    robots.clear();
+    robots.reserve(Robot::robotDeque.size());
+
+    for (int i = 0; i < Robot::robotDeque.size(); i++)
+    {
+        robots.push_back(Robot::robotDeque[i]);
+    }
+
+    // The robots at the front of the queue whose turn it is act, just like in a normal turn
+    actingCount = 0;
+    while (actingCount < (int)robots.size() && robots[actingCount]->getNextTurn() == turn)
+    {
+        actingCount++;
+    }
+
+    intents.assign(actingCount, TurnIntent());
+    hasWonCell.assign(actingCount, false);
+    isRemoved.assign(actingCount, false);
+
+    // every robot draws from its own stream, keyed on its id just like in a normal turn
+    TurnStreams streams = RNG::turnStreams(turn);
+
+    splitBoard();
+
+    // the index of occupied cells belongs to this thread, so the bands are handed it
+    const SpatialIndex *occupiedCells = Robot::occupiedCells;
+
+    runInParallel(bands.size(), [&](int bandIndex) {
+        decideBand(bandIndex, streams, occupiedCells);
+    });
+
+    TRACE_SCOPE("resolve intents");
+
+    for (int i = 0; i < actingCount; i++)
+    {
+        for (int j = 0; j < intents[i].spottedCount; j++)
+        {
+            Robot *spotted = intents[i].spotted[j];
+            Log::enemySpotted(robots[i]->getName(), spotted->getName(), spotted->getPositionX(), spotted->getPositionY());
+        }
+    }
+
+    moveRobots();
+    sortCells();
+
+    targets.assign((size_t)actingCount * TARGET_SLOTS, -1);
+
+    int blockCount = max(1, min(threadCount, actingCount / MIN_ROBOTS_PER_THREAD));
+    runInParallel(blockCount, [&](int block) {
+        findTargets((long long)actingCount * block / blockCount, (long long)actingCount * (block + 1) / blockCount);
+    });
+
+    trampleRobots();
+    fireShots();
+    finishTurn(turn);
+}
+
+inline int SimultaneousTurn::bandOf(int posY) const
+{
+    return posY / bandHeight;
+}
+
+/// @brief Splits the board into bands and hands every robot to the band it stands in
+inline void SimultaneousTurn::splitBoard()
+{
+    int height = max(Board::getHeight(), 1);
+    int bandCount = max(1, min(threadCount, actingCount / MIN_ROBOTS_PER_THREAD));
+
+    bandHeight = (height + bandCount - 1) / bandCount;
+    bandCount = (height + bandHeight - 1) / bandHeight;
+
+    // the bands keep their memory from one turn to the next
+    bands.resize(bandCount);
+
+    for (int i = 0; i < bandCount; i++)
+    {
+        bands[i].top = i * bandHeight;
+        bands[i].bottom = min(height, (i + 1) * bandHeight) - 1;
+        bands[i].robots.clear();
+        bands[i].topRow.clear();
+        bands[i].bottomRow.clear();
+        bands[i].moves.clear();
+        bands[i].cells.clear();
+    }
+
+    for (int i = 0; i < (int)robots.size(); i++)
+    {
+        int posY = robots[i]->getPositionY();
+        Band &band = bands[bandOf(posY)];
+
+        band.robots.push_back(i);
+
+        if (posY == band.top)
+        {
+            band.topRow.push_back(i);
+        }
+
+        if (posY == band.bottom)
+        {
+            band.bottomRow.push_back(i);
+        }
+    }
+}
+
+/// @brief Builds the view of a band and decides the intents of its acting robots
+inline void SimultaneousTurn::decideBand(int bandIndex, const TurnStreams &streams, const SpatialIndex *occupiedCells)
+{
+    Band &band = bands[bandIndex];
+
+    TRACE_SCOPE("decide intents", "\"robots\":" + to_string(band.robots.size()));
+
+    band.view.reset(streams, band.top - 1, band.bottom + 1, band.robots.size() + band.topRow.size() + band.bottomRow.size(), occupiedCells);
+
+    // Every cell belongs to one band, so adding each list in robot queue order keeps the earliest robot on every cell
+    for (int i : band.robots)
+    {
+        band.view.add(robots[i], i);
+    }
+
+    if (bandIndex > 0)
+    {
+        for (int i : bands[bandIndex - 1].bottomRow)
+        {
+            band.view.add(robots[i], i);
+        }
+    }
+
+    if (bandIndex + 1 < (int)bands.size())
+    {
+        for (int i : bands[bandIndex + 1].topRow)
+        {
+            band.view.add(robots[i], i);
+        }
+    }
+
+    band.view.arrange();
+
+    // The robots are decided in the order the view stores them, so the cells each one looks
+    // at are near the cells the one before it looked at. Every decision depends only on the
+    // view & the robot's own random numbers, so this gives the same intents as deciding them
+    // in robot queue order, which band.robots keeps for the rest of the turn
+    band.view.forEachRobot([&](const TurnView::Entry &entry) {
+        if (entry.robotIndex < actingCount && entry.posY >= band.top && entry.posY <= band.bottom)
+        {
+            IntentRandom random = band.view.randomFor(entry.robot->getId());
+            entry.robot->decideTurn(band.view, random, intents[entry.robotIndex]);
+        }
+    });
+}
+
+/// @brief Moves every robot whose target cell it won
+inline void SimultaneousTurn::moveRobots()
+{
+    for (int i = 0; i < actingCount; i++)
+    {
+        if (intents[i].isMoving)
+        {
+            bands[bandOf(intents[i].moveY)].moves.push_back({TurnView::cellKey(intents[i].moveX, intents[i].moveY), i});
+        }
+    }
+
+    // the robot that is first for a cell wins it. Every cell belongs to one band, so the bands settle their cells separately
+    runInParallel(bands.size(), [&](int bandIndex) {
+        vector<pair<long long, int>> &moves = bands[bandIndex].moves;
+
+        sort(moves.begin(), moves.end());
+
+        for (size_t i = 0; i < moves.size(); i++)
+        {
+            if (i == 0 || moves[i].first != moves[i - 1].first)
+            {
+                hasWonCell[moves[i].second] = true;
+            }
+        }
+    });
+
+    // the moves are carried out in robot queue order
+    for (int i = 0; i < actingCount; i++)
+    {
+        if (hasWonCell[i])
+        {
+            robots[i]->updatePositionX(intents[i].moveX);
+            robots[i]->updatePositionY(intents[i].moveY);
+            Log::move(robots[i]->getName(), intents[i].moveX, intents[i].moveY);
+        }
+        else
+        {
+            // a robot that could not move does not trample either
+            intents[i].isTrampling = intents[i].isTrampling && !intents[i].isMoving;
+        }
+    }
+}
+
+/// @brief Sorts the acting robots of every band by the cell they are on after moving
+inline void SimultaneousTurn::sortCells()
+{
+    for (int i = 0; i < actingCount; i++)
+    {
+        bands[bandOf(robots[i]->getPositionY())].cells.push_back({TurnView::cellKey(robots[i]->getPositionX(), robots[i]->getPositionY()), i});
+    }
+
+    runInParallel(bands.size(), [&](int bandIndex) {
+        sort(bands[bandIndex].cells.begin(), bands[bandIndex].cells.end());
+    });
+}
+
+/// @brief Finds the cells every trample & shot of the robots in [begin, end) lands on
+inline void SimultaneousTurn::findTargets(int begin, int end)
+{
+    auto find = [&](int posX, int posY) {
+        const vector<pair<long long, int>> &cells = bands[bandOf(posY)].cells;
+        long long key = TurnView::cellKey(posX, posY);
+
+        auto cell = lower_bound(cells.begin(), cells.end(), make_pair(key, INT_MIN));
+
+        return cell != cells.end() && cell->first == key ? (int)(cell - cells.begin()) : -1;
+    };
+
+    for (int i = begin; i < end; i++)
+    {
+        if (intents[i].isTrampling)
+        {
+            targets[(size_t)i * TARGET_SLOTS] = find(robots[i]->getPositionX(), robots[i]->getPositionY());
+        }
+
+        for (int shot = 0; shot < intents[i].shotCount; shot++)
+        {
+            targets[(size_t)i * TARGET_SLOTS + 1 + shot] = find(intents[i].shotX[shot], intents[i].shotY[shot]);
+        }
+    }
+}
+
+/// @return index of the robot earliest in the robot queue that is still on a cell, -1 if there is none
+/// @param first the first entry of the cell in its band's cells, as found by findTargets, or -1
+/// @param ignoredIndex index of a robot that is never returned
+inline int SimultaneousTurn::findTarget(int posX, int posY, int first, int ignoredIndex) const
+{
+    if (first == -1)
+    {
+        return -1;
+    }
+
+    const vector<pair<long long, int>> &cells = bands[bandOf(posY)].cells;
+    long long key = TurnView::cellKey(posX, posY);
+
+    for (size_t cell = first; cell < cells.size() && cells[cell].first == key; cell++)
+    {
+        if (!isRemoved[cells[cell].second] && cells[cell].second != ignoredIndex)
+        {
+            return cells[cell].second;
+        }
+    }
+
+    return -1;
+}
+
+inline void SimultaneousTurn::removeRobot(int killerIndex, int victimIndex)
+{
+    // the victim is dropped from the robot queue in finishTurn
+    robots[killerIndex]->killWithoutRemoving(robots[victimIndex]);
+    isRemoved[victimIndex] = true;
+}
+
+inline void SimultaneousTurn::trampleRobots()
+{
+    for (int i = 0; i < actingCount; i++)
+    {
+        if (!intents[i].isTrampling || isRemoved[i])
+            continue;
+
+        int victim = findTarget(robots[i]->getPositionX(), robots[i]->getPositionY(), targets[(size_t)i * TARGET_SLOTS], i);
+
+        if (victim != -1)
+        {
+            Log::trample(robots[i]->getName(), robots[victim]->getName());
+            removeRobot(i, victim);
+        }
+    }
+}
+
+inline void SimultaneousTurn::fireShots()
+{
+    for (int i = 0; i < actingCount; i++)
+    {
+        for (int shot = 0; shot < intents[i].shotCount && !isRemoved[i]; shot++)
+        {
+            Log::fire(robots[i]->getName(), intents[i].shotX[shot], intents[i].shotY[shot]);
+
+            int victim = findTarget(intents[i].shotX[shot], intents[i].shotY[shot], targets[(size_t)i * TARGET_SLOTS + 1 + shot], i);
+
+            if (victim != -1)
+            {
+                Log::fireHit(robots[i]->getName(), robots[victim]->getName());
+                removeRobot(i, victim);
+            }
+        }
+    }
+}
+
+/// @brief Drops the killed robots from the robot queue, evolves the robots that are
+/// ready to and moves every robot that acted to the back of the queue, just like a normal turn does
+inline void SimultaneousTurn::finishTurn(int turn)
+{
+    // the acting robots are still at the front of the queue, in order
+    for (int i = 0; i < actingCount; i++)
+    {
+        if (isRemoved[i])
+        {
+            Robot::robotDeque.pop_front();
+            continue;
+        }
+
+        robots[i]->setNextTurn(turn + 1);
+
+        if (intents[i].evolvesWhenReady && robots[i]->getReadyToEvolveState())
+        {
+            robots[i]->evolve();
+        }
+
+        Robot::robotDeque.push_back(Robot::robotDeque.pop_front());
+    }
+}
+
+#endif
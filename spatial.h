@@ -0,0 +1,353 @@
+/*
+ *
+ * This file contains the SpatialIndex class that finds the robots inside an
+ * area of the board without looking at every robot
+ *
+ * --- Code Summary ---
+ * The board is split into square tiles whose size is a power of two, chosen
+ * so that there are about as many tiles as robots. Every tile keeps a list of
+ * the robots standing on it. Finding the robots inside a rectangle only visits
+ * the tiles that overlap the rectangle, so the time taken grows with the size
+ * of the rectangle & the number of robots inside it, not with the size of the
+ * board or the total number of robots. Finding the robots within a Manhattan
+ * distance of a cell (the diamond a robot fires into) works the same way,
+ * skipping the tiles of the enclosing square that lie entirely outside the
+ * diamond.
+ *
+ * The robots nearest to a cell are found by visiting rings of tiles around the
+ * cell's tile, nearest ring first, and stopping once no robot in the next ring
+ * can be nearer than the robots found so far. Distances are counted in moves
+ * (Chebyshev distance), since robots move one cell in any of 8 directions.
+ *
+ * Robots are identified by an index chosen by the caller (e.g. their position
+ * in a list of robots) and can be inserted, removed & moved one at a time.
+ *
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+/// @brief A robot stored in the spatial index
+struct SpatialEntry
+{
+    int posX;
+    int posY;
+    int index;
+};
+
+class SpatialIndex
+{
+private:
+    int width = 0;
+    int height = 0;
+
+    /// @brief tiles are (1 << tileShift) cells wide & high
+    int tileShift = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+
+    /// @brief robots on every tile, row by row
+    vector<vector<SpatialEntry>> tiles;
+
+    vector<SpatialEntry> &tileAt(int posX, int posY);
+
+public:
+    /// @brief Chooses the size of the tiles an area is split into: the smallest power of
+    /// two that leaves no more tiles than robots (with at least 64 tiles allowed)
+    /// @param width width of the area
+    /// @param height height of the area
+    /// @param expectedCount number of robots in the area
+    /// @return the tile shift, tiles being (1 << shift) cells wide & high
+    static int tileShiftFor(int width, int height, int expectedCount);
+
+    /// @brief Removes every robot and sizes the tiles for a board
+    /// @param width board width
+    /// @param height board height
+    /// @param expectedCount number of robots that will be inserted
+    void reset(int width, int height, int expectedCount);
+
+    /// @brief Adds a robot
+    /// @param posX X position of the robot
+    /// @param posY Y position of the robot
+    /// @param index index identifying the robot
+    void insert(int posX, int posY, int index);
+
+    /// @brief Removes a robot
+    /// @param posX X position the robot was inserted at
+    /// @param posY Y position the robot was inserted at
+    /// @param index index identifying the robot
+    void remove(int posX, int posY, int index);
+
+    /// @brief Moves a robot to a new position
+    void move(int oldX, int oldY, int newX, int newY, int index);
+
+    /// @return the width & height of a tile
+    int getTileSize() const;
+
+    /// @brief Calls visit(entry) for every robot inside a rectangle. The order of the robots is unspecified
+    /// @param minX smallest X position of the rectangle
+    /// @param minY smallest Y position of the rectangle
+    /// @param maxX largest X position of the rectangle (inclusive)
+    /// @param maxY largest Y position of the rectangle (inclusive)
+    /// @param visit function called with the SpatialEntry of every robot
+    template <typename Visit>
+    void forEachInRectangle(int minX, int minY, int maxX, int maxY, Visit visit) const;
+
+    /// @brief Calls visit(entry) for every robot within a Manhattan distance of a cell. The order of the robots is unspecified
+    /// @param centerX X position of the cell
+    /// @param centerY Y position of the cell
+    /// @param radius largest distance from the cell (inclusive)
+    /// @param visit function called with the SpatialEntry of every robot
+    template <typename Visit>
+    void forEachInDiamond(int centerX, int centerY, int radius, Visit visit) const;
+
+    /// @brief Finds the robots nearest to a cell, counting the moves needed to reach them
+    /// @param posX X position of the cell
+    /// @param posY Y position of the cell
+    /// @param count largest number of robots to find
+    /// @param ignoredIndex index of a robot that is never found, e.g. the robot searching
+    /// @param found receives the robots found, nearest first. Robots at the same
+    /// distance are ordered by position (row, then column), so the result does not
+    /// depend on the size of the tiles
+    /// @return number of robots found, less than count if the index holds fewer robots
+    int findNearest(int posX, int posY, int count, int ignoredIndex, SpatialEntry *found) const;
+};
+
+inline int SpatialIndex::tileShiftFor(int width, int height, int expectedCount)
+{
+    // Grow the tiles until there are no more tiles than robots
+    long long maxTiles = max(expectedCount, 64);
+    int shift = 0;
+
+    while (shift < 30 && (long long)(((width - 1) >> shift) + 1) * (((height - 1) >> shift) + 1) > maxTiles)
+    {
+        shift++;
+    }
+
+    return shift;
+}
+
+inline void SpatialIndex::reset(int width, int height, int expectedCount)
+{
+    this->width = width;
+    this->height = height;
+
+    tileShift = tileShiftFor(width, height, expectedCount);
+    tilesX = ((width - 1) >> tileShift) + 1;
+    tilesY = ((height - 1) >> tileShift) + 1;
+
+    // the lists keep their memory when the index is reset for another frame
+    if ((int)tiles.size() != tilesX * tilesY)
+    {
+        tiles.assign(tilesX * tilesY, vector<SpatialEntry>());
+    }
+    else
+    {
+        for (vector<SpatialEntry> &tile : tiles)
+        {
+            tile.clear();
+        }
+    }
+}
+
+inline vector<SpatialEntry> &SpatialIndex::tileAt(int posX, int posY)
+{
+    return tiles[(posY >> tileShift) * tilesX + (posX >> tileShift)];
+}
+
+inline void SpatialIndex::insert(int posX, int posY, int index)
+{
+    tileAt(posX, posY).push_back({posX, posY, index});
+}
+
+inline void SpatialIndex::remove(int posX, int posY, int index)
+{
+    vector<SpatialEntry> &tile = tileAt(posX, posY);
+
+    for (size_t i = 0; i < tile.size(); i++)
+    {
+        if (tile[i].index == index)
+        {
+            tile[i] = tile.back();
+            tile.pop_back();
+            return;
+        }
+    }
+}
+
+inline void SpatialIndex::move(int oldX, int oldY, int newX, int newY, int index)
+{
+    if ((oldX >> tileShift) == (newX >> tileShift) && (oldY >> tileShift) == (newY >> tileShift))
+    {
+        for (SpatialEntry &entry : tileAt(oldX, oldY))
+        {
+            if (entry.index == index)
+            {
+                entry.posX = newX;
+                entry.posY = newY;
+                return;
+            }
+        }
+    }
+
+    remove(oldX, oldY, index);
+    insert(newX, newY, index);
+}
+
+inline int SpatialIndex::getTileSize() const
+{
+    return 1 << tileShift;
+}
+
+template <typename Visit>
+inline void SpatialIndex::forEachInRectangle(int minX, int minY, int maxX, int maxY, Visit visit) const
+{
+    minX = max(minX, 0);
+    minY = max(minY, 0);
+    maxX = min(maxX, width - 1);
+    maxY = min(maxY, height - 1);
+
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    for (int tileY = minY >> tileShift; tileY <= maxY >> tileShift; tileY++)
+    {
+        for (int tileX = minX >> tileShift; tileX <= maxX >> tileShift; tileX++)
+        {
+            for (const SpatialEntry &entry : tiles[tileY * tilesX + tileX])
+            {
+                if (entry.posX >= minX && entry.posX <= maxX && entry.posY >= minY && entry.posY <= maxY)
+                {
+                    visit(entry);
+                }
+            }
+        }
+    }
+}
+
+inline int SpatialIndex::findNearest(int posX, int posY, int count, int ignoredIndex, SpatialEntry *found) const
+{
+    if (count <= 0 || tiles.empty())
+    {
+        return 0;
+    }
+
+    int foundCount = 0;
+    int tileSize = 1 << tileShift;
+    int centerTileX = posX >> tileShift;
+    int centerTileY = posY >> tileShift;
+    int lastRing = max(max(centerTileX, tilesX - 1 - centerTileX), max(centerTileY, tilesY - 1 - centerTileY));
+
+    auto distance = [&](const SpatialEntry &entry) {
+        return max(abs(entry.posX - posX), abs(entry.posY - posY));
+    };
+
+    auto isNearer = [&](const SpatialEntry &entry, int entryDistance, const SpatialEntry &other) {
+        int otherDistance = distance(other);
+
+        if (entryDistance != otherDistance)
+            return entryDistance < otherDistance;
+
+        return entry.posY != other.posY ? entry.posY < other.posY : entry.posX < other.posX;
+    };
+
+    // keeps the count nearest robots seen so far sorted, nearest first
+
+    auto consider = [&](const SpatialEntry &entry) {
+        if (entry.index == ignoredIndex)
+            return;
+
+        int entryDistance = distance(entry);
+        int i = foundCount < count ? foundCount++ : count;
+
+        while (i > 0 && isNearer(entry, entryDistance, found[i - 1]))
+        {
+            if (i < count)
+                found[i] = found[i - 1];
+            i--;
+        }
+
+        if (i < count)
+            found[i] = entry;
+    };
+
+    for (int ring = 0; ring <= lastRing; ring++)
+    {
+        // every cell of this ring is at least this far from the cell
+        if (foundCount == count && ring > 0 && (ring - 1) * tileSize + 1 > distance(found[count - 1]))
+        {
+            break;
+        }
+
+        for (int tileY = max(centerTileY - ring, 0); tileY <= min(centerTileY + ring, tilesY - 1); tileY++)
+        {
+            bool isEdgeRow = tileY == centerTileY - ring || tileY == centerTileY + ring;
+
+            // inside rows only have a tile on each side of the ring
+            int step = isEdgeRow ? 1 : 2 * ring;
+
+            for (int tileX = centerTileX - ring; tileX <= centerTileX + ring; tileX += max(step, 1))
+            {
+                if (tileX < 0 || tileX >= tilesX)
+                    continue;
+
+                for (const SpatialEntry &entry : tiles[tileY * tilesX + tileX])
+                {
+                    consider(entry);
+                }
+            }
+        }
+    }
+
+    return foundCount;
+}
+
+template <typename Visit>
+inline void SpatialIndex::forEachInDiamond(int centerX, int centerY, int radius, Visit visit) const
+{
+    int minX = max(centerX - radius, 0);
+    int minY = max(centerY - radius, 0);
+    int maxX = min(centerX + radius, width - 1);
+    int maxY = min(centerY + radius, height - 1);
+
+    if (minX > maxX || minY > maxY)
+    {
+        return;
+    }
+
+    for (int tileY = minY >> tileShift; tileY <= maxY >> tileShift; tileY++)
+    {
+        // distance from the center to the nearest row of the tile
+        int tileTop = tileY << tileShift;
+        int distanceY = max(0, max(tileTop - centerY, centerY - (tileTop + (1 << tileShift) - 1)));
+
+        for (int tileX = minX >> tileShift; tileX <= maxX >> tileShift; tileX++)
+        {
+            int tileLeft = tileX << tileShift;
+            int distanceX = max(0, max(tileLeft - centerX, centerX - (tileLeft + (1 << tileShift) - 1)));
+
+            if (distanceX + distanceY > radius)
+            {
+                continue;
+            }
+
+            for (const SpatialEntry &entry : tiles[tileY * tilesX + tileX])
+            {
+                if (abs(entry.posX - centerX) + abs(entry.posY - centerY) <= radius)
+                {
+                    visit(entry);
+                }
+            }
+        }
+    }
+}
+
+#endif
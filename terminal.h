@@ -0,0 +1,240 @@
+/*
+ *
+ * This file contains the TerminalScreen class that redraws the interface in
+ * place on an ANSI terminal, writing only the characters that have changed
+ *
+ * --- Code Summary ---
+ * The screen remembers every line of the last frame it drew. The first frame
+ * clears the terminal and is written out in full. For every later frame, each
+ * line is compared with the same line of the last frame and only the runs of
+ * characters that differ are written, each preceded by an escape sequence that
+ * moves the cursor to the first of them. Runs separated by only a few equal
+ * characters are joined, since writing those characters again is cheaper than
+ * another cursor move. Lines that became shorter are cleared to their end.
+ *
+ * After every frame the cursor is left on the line below the frame and
+ * everything below it is cleared, so text written after the frame (e.g. a
+ * prompt) is overwritten by the next frame. Frames that do not fit in the
+ * terminal, with room for two lines of such text, are written out in full
+ * since the lines that scrolled off the screen can no longer be reached.
+ *
+ */
+
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace std;
+
+class TerminalScreen
+{
+private:
+    /// @brief lines of the last frame drawn, without their '\n'
+    vector<string> lines;
+
+    /// @brief true once a frame has been drawn since the screen was cleared
+    bool hasFrame = false;
+
+    /// @brief escape sequences & characters written for the last frame
+    string output;
+
+    /// @brief position of the terminal's cursor (0 based) while a frame is drawn, -1 if unknown
+    int cursorRow = -1;
+    int cursorColumn = -1;
+
+    /// @brief Equal characters between two changed runs that are written again
+    /// instead of moving the cursor past them
+    static const int MAX_JOINED_GAP = 8;
+
+    void moveCursor(int row, int column);
+    void drawLine(int row, string_view line);
+
+public:
+    /// @brief Works out what has to be written to the terminal to turn the last frame into a new one
+    /// @param frame the new frame, lines separated by '\n'
+    /// @param terminalHeight number of lines in the terminal, or 0 if unknown
+    /// @return the escape sequences & characters to write, valid until the next call
+    const string &update(string_view frame, int terminalHeight);
+
+    /// @brief Forgets the last frame, so that the next frame is written out in full
+    void reset();
+
+    /// @return number of lines in the terminal stdout is connected to, or 0 if it is not a terminal
+    static int terminalHeight();
+};
+
+inline void TerminalScreen::moveCursor(int row, int column)
+{
+    if (row == cursorRow && column == cursorColumn)
+    {
+        return;
+    }
+
+    // rows & columns are numbered from 1 in the escape sequence
+    output += "\x1b[";
+    output += to_string(row + 1);
+    output += ';';
+    output += to_string(column + 1);
+    output += 'H';
+
+    cursorRow = row;
+    cursorColumn = column;
+}
+
+inline void TerminalScreen::drawLine(int row, string_view line)
+{
+    string_view previous = row < (int)lines.size() ? string_view(lines[row]) : string_view();
+
+    if (line == previous)
+    {
+        return;
+    }
+
+    int length = line.size();
+    int column = 0;
+
+    while (column < length)
+    {
+        // skip the characters that have not changed
+        while (column < length && column < (int)previous.size() && line[column] == previous[column])
+        {
+            column++;
+        }
+
+        if (column == length)
+        {
+            break;
+        }
+
+        // the run ends once MAX_JOINED_GAP equal characters in a row are found
+        int runEnd = column + 1;
+        int equalCount = 0;
+
+        for (int i = runEnd; i < length && equalCount < MAX_JOINED_GAP; i++)
+        {
+            if (i < (int)previous.size() && line[i] == previous[i])
+            {
+                equalCount++;
+            }
+            else
+            {
+                runEnd = i + 1;
+                equalCount = 0;
+            }
+        }
+
+        moveCursor(row, column);
+        output += line.substr(column, runEnd - column);
+        cursorColumn = runEnd;
+
+        column = runEnd;
+    }
+
+    if (length < (int)previous.size())
+    {
+        // clear the rest of the line
+        moveCursor(row, length);
+        output += "\x1b[K";
+    }
+}
+
+/// @details The frame must only contain printable characters & '\n', since the
+/// cursor position is worked out by counting characters
+inline const string &TerminalScreen::update(string_view frame, int terminalHeight)
+{
+    output.clear();
+
+    int lineCount = 0;
+    for (char character : frame)
+    {
+        lineCount += character == '\n';
+    }
+
+    bool isFullFrame = !hasFrame || (terminalHeight > 0 && lineCount + 2 > terminalHeight);
+
+    if (isFullFrame)
+    {
+        // move to the top left corner and clear the whole screen
+        output += "\x1b[H\x1b[2J";
+        output += frame;
+
+        if (!frame.empty() && frame.back() != '\n')
+        {
+            output += '\n';
+        }
+
+        hasFrame = true;
+    }
+
+    // the cursor is somewhere below the last frame, wherever the text written after it left it
+    cursorRow = -1;
+    cursorColumn = -1;
+
+    int row = 0;
+    size_t lineStart = 0;
+
+    while (lineStart < frame.size())
+    {
+        size_t lineEnd = frame.find('\n', lineStart);
+        if (lineEnd == string_view::npos)
+        {
+            lineEnd = frame.size();
+        }
+
+        if (!isFullFrame)
+        {
+            drawLine(row, frame.substr(lineStart, lineEnd - lineStart));
+        }
+
+        if (row < (int)lines.size())
+        {
+            lines[row].assign(frame.substr(lineStart, lineEnd - lineStart));
+        }
+        else
+        {
+            lines.emplace_back(frame.substr(lineStart, lineEnd - lineStart));
+        }
+
+        row++;
+        lineStart = lineEnd + 1;
+    }
+
+    lines.resize(row);
+
+    if (isFullFrame)
+    {
+        return output;
+    }
+
+    // leave the cursor below the frame and clear anything left below it
+    moveCursor(row, 0);
+    output += "\x1b[J";
+
+    return output;
+}
+
+inline void TerminalScreen::reset()
+{
+    lines.clear();
+    hasFrame = false;
+}
+
+inline int TerminalScreen::terminalHeight()
+{
+    winsize size;
+
+    if (!isatty(STDOUT_FILENO) || ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0)
+    {
+        return 0;
+    }
+
+    return size.ws_row;
+}
+
+#endif
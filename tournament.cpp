@@ -0,0 +1,210 @@
+/*
+ *
+ * This file contains the command line tool that plays many continuations of
+ * one game from the same mid-game position and reports how often each robot
+ * wins
+ *
+ * --- Usage ---
+ * tournament.out <config file> [options]
+ * tournament.out --generate [generator options] [options]
+ *
+ *   --turn K             turn the game is branched at (default 0)
+ *   --branches N         number of continuations to play (default 1000)
+ *   --seed S             seed of the game up to the branching turn; branch i
+ *                        is seeded with S + 1 + i (default 0)
+ *   --threads N          number of branches played at once (default: one per
+ *                        core)
+ *
+ * With --generate the game is started from a config generated in memory by a
+ * ScenarioGenerator instead of a file. It takes the options of generate.out
+ * (--width, --height, --turns, --robots, --mix, --clustered & --spread), with
+ * the generator's seed given as --scenario-seed S (default 0).
+ *
+ * --- Summary of code ---
+ * The game is played once up to the branching turn and its state is captured.
+ * Every branch is then started from a fork of that state instead of replaying
+ * the game from turn 0, so the cost of a branch only depends on the turns
+ * played after the branching turn. All games are played headless, and the
+ * branches are played at once on a BatchRunner (see batch.h). Every branch is
+ * seeded by its number, so the results do not depend on the number of threads.
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "batch.h"
+#include "generator.h"
+#include "interface.h"
+
+using namespace std;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "Usage: " << argv[0] << " <config file | --generate [generator options]> [--turn K] [--branches N] [--seed S] [--threads N]" << endl;
+        return 1;
+    }
+
+    string configFilename = argv[1];
+    bool isGenerated = configFilename == "--generate";
+    ScenarioGenerator generator;
+    int branchTurn = 0;
+    int branchCount = 1000;
+    unsigned int seed = 0;
+    int threadCount = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        string option = argv[i];
+
+        if (i + 1 >= argc)
+        {
+            cerr << "[ERROR] Missing value for option " << option << endl;
+            return 1;
+        }
+
+        string value = argv[++i];
+
+        try
+        {
+            if (option == "--turn")
+                branchTurn = stoi(value);
+            else if (option == "--branches")
+                branchCount = stoi(value);
+            else if (option == "--seed")
+                seed = stoul(value);
+            else if (option == "--threads")
+                threadCount = stoi(value);
+            else if (isGenerated && option == "--scenario-seed")
+                generator.seed = stoul(value);
+            else if (!isGenerated || !generator.setOption(option, value))
+            {
+                cerr << "[ERROR] Unknown option " << option << endl;
+                return 1;
+            }
+        }
+        catch (const logic_error &)
+        {
+            cerr << "[ERROR] Invalid value " << value << " for option " << option << endl;
+            return 1;
+        }
+    }
+
+    GameState branchState;
+
+    try
+    {
+        RNG::seed(seed);
+
+        // the generated config only has to outlive the game's construction
+        string configText = isGenerated ? generator.generate() : string();
+        Game game = isGenerated ? Game(InMemoryConfig{configText}, true) : Game(configFilename, true);
+
+        while (game.isValidState() && game.getTurn() < branchTurn)
+        {
+            game.nextTurn();
+        }
+
+        if (!game.isValidState())
+        {
+            cerr << "[ERROR] The game ends before turn " << branchTurn << endl;
+            return 1;
+        }
+
+        branchState = game.getState();
+    }
+    catch (MappedFile::OpeningError)
+    {
+        cerr << "[ERROR] Error opening config file " << configFilename << endl;
+        return 1;
+    }
+    catch (const ConfigParser::ConfigError &error)
+    {
+        cerr << "[ERROR] " << configFilename << ":" << error.line << ":" << error.column << ": " << error.message << endl;
+        return 1;
+    }
+    catch (Scenario::InvalidScenario)
+    {
+        cerr << "[ERROR] The binary scenario file is invalid" << endl;
+        return 1;
+    }
+    catch (GameState::InvalidCheckpoint)
+    {
+        cerr << "[ERROR] The checkpoint file is invalid" << endl;
+        return 1;
+    }
+    catch (ScenarioGenerator::InvalidParameters)
+    {
+        cerr << "[ERROR] The given parameters cannot produce a valid config" << endl;
+        return 1;
+    }
+
+    /// @brief number of branches won by every robot name
+    map<string, int> wins;
+    int draws = 0;
+    long long turnsPlayed = 0;
+    chrono::nanoseconds restoreTime(0);
+
+    auto start = chrono::steady_clock::now();
+
+    BatchRunner runner(threadCount);
+
+    for (int i = 0; i < branchCount; i++)
+    {
+        runner.submit(branchState.fork(seed + 1 + i));
+    }
+
+    BatchResult result;
+
+    while (runner.nextResult(result))
+    {
+        restoreTime += result.setupTime;
+        turnsPlayed += result.turn - branchTurn;
+
+        if (!result.winner.empty())
+        {
+            wins[result.winner]++;
+        }
+        else
+        {
+            draws++;
+        }
+    }
+
+    double totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<pair<string, int>> ranking(wins.begin(), wins.end());
+    stable_sort(ranking.begin(), ranking.end(), [](const pair<string, int> &a, const pair<string, int> &b) {
+        return a.second > b.second;
+    });
+
+    cout << "Branched " << (isGenerated ? string("generated config") : configFilename) << " at turn " << branchTurn << " into " << branchCount << " games\n\n";
+    cout << left << setw(24) << "robot" << right << setw(10) << "wins" << setw(12) << "win rate" << '\n';
+
+    cout << fixed << setprecision(1);
+
+    for (const auto &robot : ranking)
+    {
+        cout << left << setw(24) << robot.first << right << setw(10) << robot.second
+             << setw(11) << 100.0 * robot.second / branchCount << "%\n";
+    }
+
+    cout << left << setw(24) << "(turn limit reached)" << right << setw(10) << draws
+         << setw(11) << 100.0 * draws / max(branchCount, 1) << "%\n\n";
+
+    cout << "average turns per branch: " << (double)turnsPlayed / max(branchCount, 1) << '\n';
+    cout << "average restore time:     " << restoreTime.count() / 1000.0 / max(branchCount, 1) << " us\n";
+    cout << "threads:                  " << runner.getThreadCount() << '\n';
+    cout << "total time:               " << totalSeconds << " s\n";
+
+    // the branches are headless, so their turns are profiled together, whichever worker played them
+    PROFILE_REPORT(cerr);
+
+    return 0;
+}
@@ -0,0 +1,310 @@
+/*
+ *
+ * This file contains the Tracer class that records what the simulation is
+ * doing as Chrome trace events, which can be opened in chrome://tracing or
+ * Perfetto (ui.perfetto.dev)
+ *
+ * --- Code Summary ---
+ * Spans (game turns, robot turns, board refreshes, revives & log flushes) are
+ * written as "complete" events when they end, and kills & evolutions are
+ * written as instant events. Events are appended as JSON text to a buffer in
+ * memory which is only written to the trace file once it is full, so tracing
+ * a turn costs little more than formatting its events.
+ *
+ * Events may be recorded from several threads. The buffer is guarded by a
+ * mutex and every thread gets its own track ("tid") in the trace.
+ *
+ * Tracing is only compiled in when TRACE_EVENTS is defined
+ * (g++ -DTRACE_EVENTS ...). Otherwise the TRACE_* macros expand to nothing
+ * and none of the code below is compiled.
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#ifdef TRACE_EVENTS
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+using namespace std;
+
+class Tracer
+{
+private:
+    /// @brief Events are written to the file once the buffer grows past this size
+    static const size_t FLUSH_SIZE = 1 << 20;
+
+    static FILE *traceFile;
+    static string buffer;
+    static bool isFirstEvent;
+    static chrono::steady_clock::time_point startTime;
+    static mutex traceMutex;
+
+    static int threadId();
+    static void appendEscaped(string &output, const string &text);
+    static void appendMicroseconds(long long nanoseconds);
+    static void beginEvent(const char *name, char phase, chrono::steady_clock::time_point time);
+    static void endEvent(const string &args);
+    static void flush();
+
+public:
+    /// @brief Starts a new trace file. Nothing is recorded until a file is opened
+    /// @param filename path of the trace file
+    static void open(const string &filename);
+
+    /// @brief Writes out all buffered events and closes the trace file
+    static void close();
+
+    static bool isOpen();
+
+    /// @brief Records a span that has ended
+    /// @param name name of the span
+    /// @param start time the span started
+    /// @param args JSON object members describing the span, e.g. "\"turn\":3"
+    static void span(const char *name, chrono::steady_clock::time_point start, const string &args);
+
+    /// @brief Records an event that happened at this moment
+    /// @param name name of the event
+    /// @param args JSON object members describing the event
+    static void instant(const char *name, const string &args);
+
+    /// @return JSON object members describing a robot
+    static string robotArgs(const string &name, const string &type);
+
+    /// @return JSON object member containing a string value
+    static string stringArg(const char *key, const string &value);
+};
+
+FILE *Tracer::traceFile = nullptr;
+string Tracer::buffer;
+bool Tracer::isFirstEvent = true;
+chrono::steady_clock::time_point Tracer::startTime;
+mutex Tracer::traceMutex;
+
+/// @return a small number identifying the calling thread, starting at 1
+inline int Tracer::threadId()
+{
+    static atomic<int> nextThreadId(1);
+    thread_local int id = nextThreadId++;
+
+    return id;
+}
+
+inline void Tracer::open(const string &filename)
+{
+    close();
+
+    lock_guard<mutex> lock(traceMutex);
+
+    traceFile = fopen(filename.c_str(), "w");
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+
+    buffer.reserve(FLUSH_SIZE + 4096);
+    buffer = "{\"traceEvents\":[\n";
+    isFirstEvent = true;
+    startTime = chrono::steady_clock::now();
+}
+
+inline void Tracer::close()
+{
+    lock_guard<mutex> lock(traceMutex);
+
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+
+    buffer += "\n],\"displayTimeUnit\":\"ns\"}\n";
+    flush();
+
+    fclose(traceFile);
+    traceFile = nullptr;
+}
+
+inline bool Tracer::isOpen()
+{
+    lock_guard<mutex> lock(traceMutex);
+
+    return traceFile != nullptr;
+}
+
+inline void Tracer::flush()
+{
+    fwrite(buffer.data(), 1, buffer.size(), traceFile);
+    buffer.clear();
+}
+
+/// @brief Appends text to output, escaping characters that are not allowed in JSON strings
+inline void Tracer::appendEscaped(string &output, const string &text)
+{
+    for (char character : text)
+    {
+        if (character == '"' || character == '\\')
+        {
+            output += '\\';
+            output += character;
+        }
+        else if ((unsigned char)character < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", character);
+            output += escaped;
+        }
+        else
+        {
+            output += character;
+        }
+    }
+}
+
+/// @brief Appends a time in microseconds to the buffer, keeping nanosecond precision
+inline void Tracer::appendMicroseconds(long long nanoseconds)
+{
+    buffer += to_string(nanoseconds / 1000);
+    buffer += '.';
+
+    string fraction = to_string(nanoseconds % 1000);
+    buffer.append(3 - fraction.size(), '0');
+    buffer += fraction;
+}
+
+inline void Tracer::beginEvent(const char *name, char phase, chrono::steady_clock::time_point time)
+{
+    if (!isFirstEvent)
+    {
+        buffer += ",\n";
+    }
+    isFirstEvent = false;
+
+    buffer += "{\"name\":\"";
+    buffer += name;
+    buffer += "\",\"ph\":\"";
+    buffer += phase;
+    buffer += "\",\"pid\":1,\"tid\":";
+    buffer += to_string(threadId());
+    buffer += ",\"ts\":";
+    appendMicroseconds(chrono::duration_cast<chrono::nanoseconds>(time - startTime).count());
+}
+
+inline void Tracer::endEvent(const string &args)
+{
+    if (!args.empty())
+    {
+        buffer += ",\"args\":{";
+        buffer += args;
+        buffer += '}';
+    }
+
+    buffer += '}';
+
+    if (buffer.size() >= FLUSH_SIZE)
+    {
+        flush();
+    }
+}
+
+inline void Tracer::span(const char *name, chrono::steady_clock::time_point start, const string &args)
+{
+    auto end = chrono::steady_clock::now();
+
+    lock_guard<mutex> lock(traceMutex);
+
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+
+    beginEvent(name, 'X', start);
+
+    buffer += ",\"dur\":";
+    appendMicroseconds(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+
+    endEvent(args);
+}
+
+inline void Tracer::instant(const char *name, const string &args)
+{
+    lock_guard<mutex> lock(traceMutex);
+
+    if (traceFile == nullptr)
+    {
+        return;
+    }
+
+    beginEvent(name, 'i', chrono::steady_clock::now());
+    buffer += ",\"s\":\"t\"";
+    endEvent(args);
+}
+
+inline string Tracer::robotArgs(const string &name, const string &type)
+{
+    return stringArg("name", name) + "," + stringArg("type", type);
+}
+
+inline string Tracer::stringArg(const char *key, const string &value)
+{
+    string arg = "\"";
+    arg += key;
+    arg += "\":\"";
+    appendEscaped(arg, value);
+    arg += '"';
+
+    return arg;
+}
+
+/// @brief Records the time between its construction and destruction as a span
+class TraceSpan
+{
+private:
+    const char *name;
+    string args;
+    chrono::steady_clock::time_point start;
+
+public:
+    TraceSpan(const char *name, const string &args = "")
+    {
+        this->name = name;
+        this->args = args;
+        start = chrono::steady_clock::now();
+    }
+
+    ~TraceSpan()
+    {
+        Tracer::span(name, start, args);
+    }
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/// @brief Starts writing trace events to the given file
+#define TRACE_OPEN(filename) Tracer::open(filename)
+
+/// @brief Writes out the remaining trace events & closes the trace file
+#define TRACE_CLOSE() Tracer::close()
+
+/// @brief Records the rest of the enclosing scope as a span. The optional
+/// second argument holds the JSON object members describing the span
+#define TRACE_SCOPE(...) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+
+/// @brief Records an instant event
+#define TRACE_INSTANT(name, args) Tracer::instant(name, args)
+
+#else
+
+#define TRACE_OPEN(filename)
+#define TRACE_CLOSE()
+#define TRACE_SCOPE(...)
+#define TRACE_INSTANT(name, args)
+
+#endif
+
+#endif